@@ -0,0 +1,59 @@
+#include "alloc.hpp"
+
+#ifdef ALLOC_STATS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<std::uint64_t> counter(0);
+}
+
+std::uint64_t alloc_count() {
+    return counter.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t n) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    if (n == 0) n = 1;
+    if (auto p = std::malloc(n)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n) {
+    return operator new(n);
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n == 0 ? 1 : n);
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t &t) noexcept {
+    return operator new(n, t);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#else
+
+std::uint64_t alloc_count() {
+    return 0;
+}
+
+#endif
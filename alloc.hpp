@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of calls to the global operator new so far.
+// The counting operator new is compiled in only with -DALLOC_STATS; otherwise this is always 0.
+std::uint64_t alloc_count();
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "cdcl/async.hpp"
+
+// Drives cdcl::Scheduler on a fixed set of searches and fails unless each ends as
+// expected: a satisfiable and an unsatisfiable formula which take several slices, a
+// trivial one, and one which its progress callback cancels halfway. Also checks that
+// the searches take turns, that progress is reported and that on_done runs once each.
+//
+// async_check (exit code 0 when every check passes)
+
+namespace {
+
+// n + 1 pigeons into n holes when extra, otherwise n into n
+std::vector<raw_clause> pigeonhole(const int n, const bool extra) {
+    const int pigeons = n + (extra ? 1 : 0);
+    auto x = [&](const int p, const int h) { return make_lit(Var(p * n + h + 1), false); };
+    std::vector<raw_clause> ret;
+    for (int p = 0; p < pigeons; p++) {
+        raw_clause c;
+        for (int h = 0; h < n; h++) c.push_back(x(p, h));
+        ret.push_back(c);
+    }
+    for (int h = 0; h < n; h++) {
+        for (int p = 0; p < pigeons; p++) {
+            for (int q = p + 1; q < pigeons; q++) ret.push_back(raw_clause { ~x(p, h), ~x(q, h) });
+        }
+    }
+    return ret;
+}
+
+// random 3-SAT with a planted model, so that it is satisfiable
+std::vector<raw_clause> planted(const int n, const int m, std::mt19937 &rng) {
+    std::vector<bool> model(n + 1);
+    for (int i = 1; i <= n; i++) model[i] = rng() % 2;
+    std::vector<raw_clause> ret;
+    while (int(ret.size()) < m) {
+        raw_clause c;
+        for (int k = 0; k < 3; k++) c.push_back(make_lit(Var(1 + rng() % n), rng() % 2));
+        const bool sat = std::any_of(std::begin(c), std::end(c), [&](const Literal p) {
+            return model[index(var(p))] != is_neg(p);
+        });
+        if (sat) ret.push_back(c);
+    }
+    return ret;
+}
+
+bool satisfies(const std::vector<raw_clause> &clauses, const Valuation &va) {
+    return std::all_of(std::begin(clauses), std::end(clauses), [&](const raw_clause &c) {
+        return std::any_of(std::begin(c), std::end(c), [&](const Literal p) { return va.get_value(p) == PValue::TRUE; });
+    });
+}
+
+struct job {
+    std::string name;
+    std::vector<raw_clause> clauses;
+    cdcl::Result expected;
+    bool cancel_halfway;
+
+    CNF *cnf;
+    Valuation *va;
+    std::atomic<bool> cancel;
+    int progress, done;
+    std::future<cdcl::Result> res;
+};
+
+}
+
+int main() {
+    constexpr std::uint64_t slice = 500;
+    std::mt19937 rng(1);
+    std::vector<job> jobs(4);
+    jobs[0].name = "pigeonhole 8 into 7";
+    jobs[0].clauses = pigeonhole(7, true);
+    jobs[0].expected = cdcl::Result::UNSAT;
+    jobs[1].name = "planted 3-SAT";
+    jobs[1].clauses = planted(250, 1050, rng);
+    jobs[1].expected = cdcl::Result::SAT;
+    jobs[2].name = "pigeonhole 5 into 5";
+    jobs[2].clauses = pigeonhole(5, false);
+    jobs[2].expected = cdcl::Result::SAT;
+    jobs[3].name = "pigeonhole 11 into 10, cancelled";
+    jobs[3].clauses = pigeonhole(10, true);
+    jobs[3].expected = cdcl::Result::Unknown;
+    jobs[3].cancel_halfway = true;
+
+    cdcl::Scheduler sched;
+    for (auto &j : jobs) {
+        j.cnf = new CNF(std::vector<raw_clause>(j.clauses));
+        j.va = new Valuation(j.cnf->get_pnum());
+        j.cancel = false;
+        j.progress = j.done = 0;
+        cdcl::Scheduler::options opt {
+            slice, cdcl::limits { 0, 0 }, &j.cancel, 100,
+            [&j](const cdcl::progress &p) {
+                j.progress++;
+                if (j.cancel_halfway && 2000 <= p.conflicts) j.cancel = true;
+            },
+            [&j](cdcl::Result) { j.done++; },
+        };
+        j.res = sched.submit(j.cnf, j.va, std::move(opt));
+    }
+
+    // the searches take turns: a long one is queued again behind the others
+    std::size_t most = 0;
+    int steps = 0;
+    while (sched.step()) {
+        most = std::max(most, sched.size());
+        steps++;
+    }
+
+    bool ok = (most == jobs.size() && int(jobs.size()) < steps);
+    if (!ok) std::cout << "no interleaving: " << steps << " steps, at most " << most << " queued" << std::endl;
+    for (auto &j : jobs) {
+        const auto res = j.res.get();
+        bool good = (res == j.expected && j.done == 1);
+        if (res == cdcl::Result::SAT) good = good && satisfies(j.clauses, *j.va);
+        // the long searches report progress
+        if (j.expected != cdcl::Result::SAT || j.cancel_halfway) good = good && 0 < j.progress;
+        std::cout << (good ? "ok   " : "FAIL ") << j.name << " (" << j.progress << " progress calls)" << std::endl;
+        ok = ok && good;
+        j.cnf->free();
+        delete j.va;
+        delete j.cnf;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include "backbone.hpp"
+#include <algorithm>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+template <typename Policy>
+Backbone<Policy>::Backbone(CNF *cnf_, Valuation *va_)
+    : cnf(cnf_),
+      va(va_),
+      solver(cnf_, va_),
+      pnum(cnf_->get_pnum()),
+      chunk(64),
+      nchecks(0),
+      log(nullptr)
+{
+}
+
+template <typename Policy>
+void Backbone<Policy>::set_limits(const cdcl::limits &l) {
+    solver.set_limits(l);
+}
+
+template <typename Policy>
+void Backbone<Policy>::set_branching(const branch_options &opt) {
+    solver.set_branching(opt);
+}
+
+template <typename Policy>
+void Backbone<Policy>::set_params(const cdcl::params &p) {
+    solver.set_params(p);
+}
+
+template <typename Policy>
+void Backbone<Policy>::set_chunk(const int k) {
+    chunk = std::max(1, k);
+}
+
+template <typename Policy>
+void Backbone<Policy>::set_log(std::ostream *os) {
+    log = os;
+}
+
+template <typename Policy>
+const cdcl::statistics& Backbone<Policy>::get_statistics() const {
+    return solver.get_statistics();
+}
+
+template <typename Policy>
+int Backbone<Policy>::checks() const {
+    return nchecks;
+}
+
+template <typename Policy>
+const std::vector<Literal>& Backbone<Policy>::get_candidates() const {
+    return cand;
+}
+
+template <typename Policy>
+std::vector<Literal> Backbone<Policy>::get_backbone() const {
+    auto ret = backbone;
+    std::sort(ALL(ret));
+    return ret;
+}
+
+template <typename Policy>
+void Backbone<Policy>::filter() {
+    cand.erase(std::remove_if(ALL(cand), [&](const Literal p) {
+        return va->get_value(p) != PValue::TRUE;
+    }), std::end(cand));
+}
+
+// a literal true at level 0 follows from the clauses alone
+template <typename Policy>
+void Backbone<Policy>::take_fixed() {
+    cand.erase(std::remove_if(ALL(cand), [&](const Literal p) {
+        if (va->get_value(p) != PValue::TRUE || va->decided(p) != 0) return false;
+        backbone.push_back(p);
+        return true;
+    }), std::end(cand));
+}
+
+template <typename Policy>
+void Backbone<Policy>::report() const {
+    if (log != nullptr) *log << "c backbone " << backbone.size() << " candidates " << cand.size() << std::endl;
+}
+
+template <typename Policy>
+cdcl::Result Backbone<Policy>::solve() {
+    const auto first = solver.search();
+    if (first != cdcl::Result::SAT) return first;
+    cand.clear();
+    for (int i = 1; i <= pnum; i++) cand.push_back(make_lit(Var(i), va->get_value(Var(i)) == PValue::FALSE));
+    take_fixed();
+    report();
+
+    while (!cand.empty()) {
+        const int k = std::min(chunk, int(cand.size()));
+        const std::vector<Literal> part(std::end(cand) - k, std::end(cand));
+        // a model falsifying many candidates at once drops them all
+        for (auto p : cand) solver.set_phase(~p);
+        const auto a = make_lit(solver.new_var(), false);
+        raw_clause c { ~a };
+        for (auto p : part) c.push_back(~p);
+        solver.add_clause(c);
+        nchecks++;
+        const auto res = solver.search({ a });
+        if (res == cdcl::Result::Unknown) return res;
+        const auto before = cand.size();
+        if (res == cdcl::Result::SAT) {
+            filter();
+        } else {
+            cand.resize(cand.size() - k);
+            for (auto p : part) {
+                backbone.push_back(p);
+                solver.add_clause(raw_clause { p });
+            }
+        }
+        // the check is over for good
+        solver.add_clause(raw_clause { ~a });
+        take_fixed();
+        if (cand.size() != before) report();
+    }
+    return cdcl::Result::SAT;
+}
+
+// default_policy with every branching policy, which main picks by cdcl::with_heuristic
+template struct Backbone<cdcl::with_branch<cdcl::default_policy, VSIDSBranch>>;
+template struct Backbone<cdcl::with_branch<cdcl::default_policy, LRBBranch>>;
+template struct Backbone<cdcl::with_branch<cdcl::default_policy, CHBBranch>>;
+template struct Backbone<cdcl::with_branch<cdcl::default_policy, SwitchBranch>>;
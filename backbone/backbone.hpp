@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include "../cnf.hpp"
+#include "../cdcl/cdcl.hpp"
+
+// The backbone: the literals true in every model, on a single incremental CDCL instance.
+// The first model makes its literals the candidates. A check takes a chunk of them and
+// asks for a model falsifying at least one, by a clause (~l1 | ... | ~lk | ~a) under the
+// assumption a (Janota et al., 2015): UNSAT puts the whole chunk into the backbone, as
+// units of the solver, and a model drops every candidate it falsifies. After every
+// check, the candidates fixed at level 0 join the backbone without a check of their own.
+// Policy is that of the solver: default_policy with any of the branching policies.
+template <typename Policy>
+struct Backbone {
+    Backbone() = delete;
+    Backbone(CNF *cnf_, Valuation *va_);
+
+    // SAT once every candidate is decided, UNSAT if the formula is, or Unknown when
+    // the limits run out, leaving some candidates undecided
+    cdcl::Result solve();
+    std::vector<Literal> get_backbone() const;  // sorted by variable
+    const std::vector<Literal>& get_candidates() const;
+    void set_limits(const cdcl::limits &l);
+    void set_branching(const branch_options &opt);
+    void set_params(const cdcl::params &p);
+    void set_chunk(const int k);  // candidates per check, 64 by default
+    // "c backbone <found> candidates <left>" whenever a check has decided some
+    void set_log(std::ostream *os);
+    const cdcl::statistics& get_statistics() const;
+    int checks() const;
+
+private:
+    CNF *cnf;
+    Valuation *va;
+    cdcl::Solver<Policy> solver;
+    int pnum;  // variables of cnf_; the activation literals of the checks follow them
+    int chunk, nchecks;
+    std::ostream *log;
+    std::vector<Literal> backbone, cand;
+
+    void filter();  // drops the candidates false in the model of va
+    void take_fixed();
+    void report() const;
+};
@@ -0,0 +1,166 @@
+#include "batch.hpp"
+#include "util.hpp"
+#include "cdcl/cdcl.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct batch_result {
+    std::string file;
+    std::string status;
+    double seconds;
+    int vars, clauses;
+    cdcl::statistics stats;
+};
+
+void solve_file(const std::string &file, const batch_options &opt, batch_result &res) {
+    std::ifstream in(file);
+    int pn = 0;
+    std::vector<AtMost> cards;
+    std::vector<raw_clause> xors;
+    auto clauses = (in ? parse_clauses(in, pn, &cards, &xors) : std::nullopt);
+    if (clauses.has_value()) {
+        res.vars = pn;
+        res.clauses = clauses->size() + cards.size() + xors.size();
+        CNF cnf(std::move(*clauses), std::move(cards), std::move(xors));
+        Valuation va(cnf.get_pnum());
+        try {
+            cdcl::CDCL solver(&cnf, &va);
+            solver.set_limits(cdcl::limits { opt.conflicts, opt.seconds });
+            switch (solver.search()) {
+                case cdcl::Result::SAT:
+                    res.status = "SAT";
+                    break;
+                case cdcl::Result::UNSAT:
+                    res.status = "UNSAT";
+                    break;
+                case cdcl::Result::Unknown:
+                    res.status = "UNKNOWN";
+                    break;
+            }
+            res.stats = solver.get_statistics();
+        } catch (...) {
+            cnf.free();
+            throw;
+        }
+        cnf.free();
+    }
+}
+
+batch_result solve_one(const std::string &file, const batch_options &opt) {
+    const auto start = std::chrono::steady_clock::now();
+    batch_result res { file, "ERROR", 0, 0, 0, cdcl::statistics { } };
+    try {
+        solve_file(file, opt, res);
+    } catch (const std::exception &) {
+        // a throw in a worker would end the whole batch
+        res.status = "ERROR";
+    }
+
+    const std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    res.seconds = d.count();
+    return res;
+}
+
+std::string escape_json(const std::string &s) {
+    std::string ret;
+    for (auto c : s) {
+        if (c == '"' || c == '\\') ret += '\\';
+        ret += c;
+    }
+    return ret;
+}
+
+std::string escape_csv(const std::string &s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string ret = "\"";
+    for (auto c : s) {
+        if (c == '"') ret += '"';
+        ret += c;
+    }
+    return ret + '"';
+}
+
+std::string format_row(const batch_result &r, const bool json) {
+    std::ostringstream os;
+    const auto &st = r.stats;
+    if (json) {
+        os << "{\"file\":\"" << escape_json(r.file) << "\",\"result\":\"" << r.status
+           << "\",\"seconds\":" << r.seconds << ",\"vars\":" << r.vars << ",\"clauses\":" << r.clauses
+           << ",\"conflicts\":" << st.conflicts << ",\"decisions\":" << st.decisions
+           << ",\"propagations\":" << st.propagations << ",\"restarts\":" << st.restarts << "}\n";
+    } else {
+        os << escape_csv(r.file) << ',' << r.status << ',' << r.seconds << ',' << r.vars << ',' << r.clauses
+           << ',' << st.conflicts << ',' << st.decisions << ',' << st.propagations << ',' << st.restarts << '\n';
+    }
+    return os.str();
+}
+
+}
+
+std::optional<std::vector<std::string>> collect_instances(const std::string &source) {
+    std::vector<std::string> ret;
+    std::error_code ec;
+    if (fs::is_directory(source, ec)) {
+        for (fs::directory_iterator it(source, ec), last; !ec && it != last; it.increment(ec)) {
+            std::error_code file_ec;
+            if (it->is_regular_file(file_ec) && it->path().extension() == ".cnf") ret.push_back(it->path().string());
+        }
+        if (ec) return std::nullopt;
+        std::sort(std::begin(ret), std::end(ret));
+        return ret;
+    }
+
+    std::ifstream in(source);
+    if (!in) return std::nullopt;
+    const auto base = fs::path(source).parent_path();
+    std::string s;
+    while (std::getline(in, s)) {
+        if (s.empty() || s[0] == '#') continue;
+        const fs::path p(s);
+        ret.push_back((p.is_absolute() ? p : base / p).string());
+    }
+    return ret;
+}
+
+bool run_batch(const std::vector<std::string> &files, const batch_options &opt) {
+    std::ofstream file_out;
+    if (!opt.output.empty()) {
+        file_out.open(opt.output);
+        if (!file_out) return false;
+    }
+    std::ostream &out = (opt.output.empty() ? std::cout : file_out);
+    if (!opt.json) out << "file,result,seconds,vars,clauses,conflicts,decisions,propagations,restarts\n";
+
+    int threads = (opt.threads == 0 ? int(std::thread::hardware_concurrency()) : opt.threads);
+    threads = std::max(1, std::min(threads, int(files.size())));
+
+    std::atomic<std::size_t> next(0);
+    std::mutex mtx;
+    auto worker = [&] {
+        while (true) {
+            const auto i = next.fetch_add(1);
+            if (files.size() <= i) return;
+            const auto row = format_row(solve_one(files[i], opt), opt.json);
+            std::lock_guard<std::mutex> lock(mtx);
+            out << row << std::flush;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+    return bool(out);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+struct batch_options {
+    int threads;               // 0 picks the hardware concurrency
+    std::uint64_t conflicts;   // per instance, 0 means no limit
+    double seconds;            // per instance, 0 means no limit
+    bool json;                 // JSON Lines instead of CSV
+    std::string output;        // empty means stdout
+};
+
+// CNF files of a directory (*.cnf, sorted), or the paths listed in a manifest,
+// one per line, relative to the manifest; nullopt if source cannot be read
+std::optional<std::vector<std::string>> collect_instances(const std::string &source);
+
+// Solves every instance with its own CNF / Valuation / CDCL on a pool of threads
+// and writes one result row per instance as soon as it is finished. An instance
+// which cannot be read or parsed, or runs out of memory, gets an ERROR row.
+bool run_batch(const std::vector<std::string> &files, const batch_options &opt);
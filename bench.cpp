@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+#include "util.hpp"
+#include "cdcl/cdcl.hpp"
+#include "cdcl/vsids.hpp"
+#include "cdcl/graph.hpp"
+
+// Microbenchmarks of the data structures of the solver, to tell which one moved when the
+// end-to-end times do. Every benchmark builds its input from a fixed seed, runs warm-up
+// repetitions which are not measured, then times each repetition on its own; the report
+// gives the nanoseconds per operation of the fastest, 10th, 50th and 90th percentile and
+// slowest repetition, one row per benchmark in CSV or JSON Lines.
+//
+// bench [-w warm-up] [-r repetitions] [-f csv|json] [-k substring of the names to run]
+
+namespace {
+
+// results are written here so that the compiler keeps the work producing them
+volatile std::uint64_t sink;
+
+struct bench_options {
+    int warmup, reps;
+    bool json;
+    std::string filter;
+};
+
+struct measurement {
+    std::string name;
+    std::uint64_t ops;  // per repetition
+    int reps;
+    double min, p10, median, p90, max;  // nanoseconds per operation
+};
+
+// samples sorted; nearest rank
+double percentile(const std::vector<double> &samples, const double q) {
+    const auto i = std::size_t(q * (samples.size() - 1) + 0.5);
+    return samples[std::min(i, samples.size() - 1)];
+}
+
+// prepare is run before every repetition and is not timed; run returns the operations it made
+measurement measure(const std::string &name, const bench_options &opt,
+                    const std::function<void()> &prepare, const std::function<std::uint64_t()> &run) {
+    std::uint64_t ops = 0;
+    for (int i = 0; i < opt.warmup; i++) {
+        prepare();
+        ops = run();
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < opt.reps; i++) {
+        prepare();
+        const auto start = std::chrono::steady_clock::now();
+        ops = run();
+        const std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+        samples.push_back(d.count() / std::max<std::uint64_t>(ops, 1));
+    }
+    std::sort(std::begin(samples), std::end(samples));
+    return measurement { name, ops, opt.reps, samples.front(), percentile(samples, 0.1),
+                         percentile(samples, 0.5), percentile(samples, 0.9), samples.back() };
+}
+
+void print(const measurement &m, const bool json) {
+    if (json) {
+        std::cout << "{\"name\":\"" << m.name << "\",\"ops\":" << m.ops << ",\"reps\":" << m.reps
+                  << ",\"min_ns\":" << m.min << ",\"p10_ns\":" << m.p10 << ",\"median_ns\":" << m.median
+                  << ",\"p90_ns\":" << m.p90 << ",\"max_ns\":" << m.max << "}\n";
+    } else {
+        std::cout << m.name << ',' << m.ops << ',' << m.reps << ',' << m.min << ',' << m.p10 << ','
+                  << m.median << ',' << m.p90 << ',' << m.max << '\n';
+    }
+    std::cout.flush();
+}
+
+// m random clauses of 3 distinct variables out of n
+std::vector<raw_clause> random_clauses(const int n, const int m, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> pick(1, n);
+    std::bernoulli_distribution coin;
+    std::vector<raw_clause> ret(m);
+    for (auto &c : ret) {
+        while (c.size() < 3) {
+            const auto p = make_lit(Var(pick(rng)), coin(rng));
+            if (std::none_of(std::begin(c), std::end(c), [&](const Literal q) { return var(q) == var(p); })) c.push_back(p);
+        }
+    }
+    return ret;
+}
+
+std::string dimacs(const int n, const std::vector<raw_clause> &clauses) {
+    std::ostringstream ss;
+    ss << "p cnf " << n << ' ' << clauses.size() << '\n';
+    for (const auto &c : clauses) {
+        for (auto p : c) ss << to_dimacs(p) << ' ';
+        ss << "0\n";
+    }
+    return ss.str();
+}
+
+// Every variable assigned: a decision opens each block of 32 levels' worth of variables,
+// and the others are implied by a clause over two variables assigned before them.
+struct implication_chain {
+    int n;
+    Valuation va;
+    std::vector<Clause*> reasons;
+
+    implication_chain(const int n_, std::mt19937 &rng)
+        : n(n_),
+          va(n_)
+    {
+        std::bernoulli_distribution coin;
+        for (int i = 1; i <= n; i++) {
+            const auto p = make_lit(Var(i), coin(rng));
+            const int dl = 1 + (i - 1) / 32;
+            if ((i - 1) % 32 == 0) {
+                va.assign(Var(i), is_neg(p) ? PValue::FALSE : PValue::TRUE, dl);
+                continue;
+            }
+            std::uniform_int_distribution<int> back(std::max(1, i - 64), i - 1);
+            raw_clause r { p };
+            for (int k = 0; k < 2; k++) {
+                const auto v = Var(back(rng));
+                r.push_back(make_lit(v, va.get_value(v) == PValue::TRUE));
+            }
+            // the constructor sorts the literals, and a reason keeps the implied one first
+            auto c = new Clause(r);
+            auto &lits = c->raw();
+            std::swap(*std::find(std::begin(lits), std::end(lits), p), lits[0]);
+            reasons.push_back(c);
+            va.imply(p, dl, c);
+        }
+    }
+
+    ~implication_chain() {
+        for (auto c : reasons) delete c;
+    }
+
+    // false literals of size distinct variables, the asserting one of the last level first
+    raw_clause conflict_clause(const int size, std::mt19937 &rng) const {
+        std::vector<int> vars(n);
+        for (int i = 0; i < n; i++) vars[i] = i + 1;
+        std::shuffle(std::begin(vars), std::end(vars), rng);
+        vars.resize(size);
+        std::swap(*std::max_element(std::begin(vars), std::end(vars)), vars[0]);
+        raw_clause r;
+        for (auto v : vars) r.push_back(make_lit(Var(v), va.get_value(Var(v)) == PValue::TRUE));
+        return r;
+    }
+};
+
+void run_all(const bench_options &opt) {
+    auto wanted = [&](const std::string &name) { return name.find(opt.filter) != std::string::npos; };
+    auto bench = [&](const std::string &name, const std::function<void()> &prepare,
+                     const std::function<std::uint64_t()> &run) {
+        if (wanted(name)) print(measure(name, opt, prepare, run), opt.json);
+    };
+    auto nothing = [] { };
+
+    constexpr int n = 20000;
+    std::mt19937 rng(1);
+    const auto clauses = random_clauses(n, int(n * 4.26), rng);
+
+    {
+        SegmentTree seg(n);
+        std::uniform_int_distribution<int> pick(1, n);
+        std::vector<Var> vars(100000);
+        for (auto &v : vars) v = Var(pick(rng));
+        bench("segtree.inc_get", nothing, [&] {
+            std::uint64_t sum = 0;
+            for (auto v : vars) {
+                seg.inc(v);
+                sum += seg.get().idx;
+            }
+            sink = sum;
+            return vars.size();
+        });
+    }
+
+    {
+        VSIDS vsids(n, 2, 256);
+        bench("vsids.bump_pick", nothing, [&] {
+            std::vector<Var> assigned;
+            for (const auto &c : clauses) {
+                vsids.vsi(c);
+                const auto v = vsids.pickup();
+                vsids.assign(*v);
+                assigned.push_back(*v);
+                if (assigned.size() == 64) {
+                    for (auto u : assigned) vsids.rollback(u);
+                    assigned.clear();
+                }
+            }
+            for (auto u : assigned) vsids.rollback(u);
+            return clauses.size();
+        });
+    }
+
+    {
+        CNF cnf { std::vector<raw_clause>(clauses) };
+        std::vector<cdcl::Watcher> watcher;
+        bench("watcher.add_clean", [&] {
+            for (int i = 0; i < cnf.size(); i++) cnf.get(i)->type = ClauseType::Original;
+            watcher.clear();
+            watcher.emplace_back(&cnf);
+        }, [&] {
+            for (int i = 0; i < cnf.size(); i++) {
+                watcher[0].add_watch(cnf.get(i));
+                if (i % 2 == 1) cnf.get(i)->type = ClauseType::Removed;
+            }
+            watcher[0].clean();
+            return std::uint64_t(cnf.size());
+        });
+        bench("watcher.get", nothing, [&] {
+            std::uint64_t sum = 0;
+            for (int i = 2; i < 2 * (n + 1); i++) {
+                for (const auto &w : watcher[0].get(Literal(i))) sum += index(w.blocker);
+            }
+            sink = sum;
+            return std::uint64_t(2 * n);
+        });
+        for (int i = 0; i < cnf.size(); i++) cnf.get(i)->type = ClauseType::Original;
+        cnf.free();
+    }
+
+    {
+        implication_chain chain(n, rng);
+        const auto &va = chain.va;
+        std::uniform_int_distribution<int> pick(1, n);
+        std::vector<Literal> lits(100000);
+        for (auto &p : lits) p = make_lit(Var(pick(rng)), pick(rng) % 2);
+        bench("valuation.get_value", nothing, [&] {
+            std::uint64_t sum = 0;
+            for (auto p : lits) sum += int(va.get_value(p)) + va.decided(p);
+            sink = sum;
+            return lits.size();
+        });
+
+        LevelStamp stamp(n);
+        std::vector<Clause*> learnts;
+        for (int i = 0; i < 1000; i++) learnts.push_back(new Clause(chain.conflict_clause(30, rng), &va, stamp));
+        bench("clause.recalc_lbd", nothing, [&] {
+            for (auto c : learnts) c->recalc_LBD(&va, stamp);
+            return learnts.size();
+        });
+        for (auto c : learnts) delete c;
+
+        std::vector<raw_clause> conflicts, work;
+        for (int i = 0; i < 1000; i++) conflicts.push_back(chain.conflict_clause(30, rng));
+        ImplicationGraph igraph(n);
+        auto reset = [&] { work = conflicts; };
+        bench("igraph.local_minimize", reset, [&] {
+            for (auto &r : work) igraph.local_minimize(r, &va);
+            return work.size();
+        });
+        bench("igraph.recursive_minimize", reset, [&] {
+            for (auto &r : work) igraph.recursive_minimize(r, &va);
+            return work.size();
+        });
+    }
+
+    {
+        const auto text = dimacs(n, clauses);
+        bench("parse", nothing, [&] {
+            std::istringstream in(text);
+            auto [ cnf, pn, line ] = parse(in);
+            cnf->free();
+            delete cnf;
+            sink = pn;
+            return clauses.size();
+        });
+    }
+
+    {
+        // conflict analysis, minimization and propagation together, per conflict
+        constexpr int m = 300;
+        std::mt19937 g(7);
+        const auto small = random_clauses(m, int(m * 4.26), g);
+        constexpr std::uint64_t limit = 5000;
+        std::uint64_t conflicts = 0;
+        bench("cdcl.conflict", nothing, [&] {
+            CNF cnf { std::vector<raw_clause>(small) };
+            Valuation va(cnf.get_pnum());
+            {
+                cdcl::CDCL solver(&cnf, &va);
+                solver.set_limits(cdcl::limits { limit, 0 });
+                solver.search();
+                conflicts = solver.get_statistics().conflicts;
+            }
+            cnf.free();
+            return conflicts;
+        });
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt { 3, 15, false, "" };
+    {
+        int o;
+        while ((o = getopt(argc, argv, "w:r:f:k:")) != -1) {
+            switch (o) {
+                case 'w':
+                    opt.warmup = std::stoi(optarg);
+                    break;
+                case 'r':
+                    opt.reps = std::max(1, std::stoi(optarg));
+                    break;
+                case 'f':
+                    opt.json = (std::string(optarg) == "json");
+                    break;
+                case 'k':
+                    opt.filter = optarg;
+                    break;
+                default:
+                    std::cerr << "usage: " << argv[0] << " [-w warm-up] [-r repetitions] [-f csv|json] [-k name]" << std::endl;
+                    return 2;
+            }
+        }
+    }
+    if (!opt.json) std::cout << "name,ops,reps,min_ns,p10_ns,median_ns,p90_ns,max_ns\n";
+    run_all(opt);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "async.hpp"
+#include <algorithm>
+
+namespace cdcl {
+
+Scheduler::task::task(CNF *cnf, Valuation *va, options &&opt_)
+    : solver(cnf, va),
+      opt(std::move(opt_)),
+      start(std::chrono::steady_clock::now())
+{
+    solver.set_cancel(opt.cancel);
+    if (opt.on_progress) solver.set_progress(opt.on_progress, opt.interval);
+}
+
+std::future<Result> Scheduler::submit(CNF *cnf, Valuation *va, options opt) {
+    que.push_back(std::make_unique<task>(cnf, va, std::move(opt)));
+    return que.back()->done.get_future();
+}
+
+bool Scheduler::step() {
+    if (que.empty()) return false;
+    auto t = std::move(que.front());
+    que.pop_front();
+
+    const auto &lim = t->opt.lim;
+    auto left = [&] {
+        const std::chrono::duration<double> d = std::chrono::steady_clock::now() - t->start;
+        return lim.seconds - d.count();
+    };
+    // the conflict limit of CDCL counts from the first search, the time limit from this one
+    auto turn = limits { t->solver.get_statistics().conflicts + std::max<std::uint64_t>(t->opt.slice, 1), 0 };
+    if (lim.conflicts != 0) turn.conflicts = std::min(turn.conflicts, lim.conflicts);
+    if (lim.seconds != 0) turn.seconds = std::max(left(), 1e-9);
+    t->solver.set_limits(turn);
+
+    const auto res = t->solver.search();
+    if (res == Result::Unknown) {
+        const bool cancelled = (t->opt.cancel != nullptr && t->opt.cancel->load());
+        const bool exhausted = (lim.conflicts != 0 && lim.conflicts <= t->solver.get_statistics().conflicts)
+                            || (lim.seconds != 0 && left() <= 0);
+        if (!cancelled && !exhausted) {
+            que.push_back(std::move(t));
+            return true;
+        }
+    }
+    if (t->opt.on_done) t->opt.on_done(res);
+    t->done.set_value(res);
+    return true;
+}
+
+void Scheduler::run() {
+    while (step()) { }
+}
+
+std::size_t Scheduler::size() const {
+    return que.size();
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <deque>
+#include <future>
+#include <memory>
+#include "cdcl.hpp"
+
+namespace cdcl {
+
+// Drives many searches from a single thread, e.g. an event loop: every step() runs
+// the next search in turn for one slice of conflicts, after which it stops at level 0
+// with its learnt clauses and heuristic state kept and is queued again.
+struct Scheduler {
+    struct options {
+        // conflicts per turn; a turn ends at level 0, so its end is also a restart, and a
+        // slice shorter than the restart interval restarts more often than the policy does
+        std::uint64_t slice;
+        limits lim;              // over the whole search; seconds count from submit()
+        const std::atomic<bool> *cancel;  // may be nullptr; a cancelled search ends Unknown
+        std::uint64_t interval;  // conflicts between calls of on_progress, 0: none
+        std::function<void(const progress&)> on_progress;
+        std::function<void(Result)> on_done;  // called before the future is ready
+    };
+
+    Scheduler() = default;
+    Scheduler(const Scheduler&) = delete;
+
+    // cnf and va must outlive the search; va holds the model after SAT
+    std::future<Result> submit(CNF *cnf, Valuation *va, options opt);
+    bool step();  // false when no search is left
+    void run();   // steps until every search has finished
+    std::size_t size() const;
+
+private:
+    struct task {
+        CDCL solver;
+        options opt;
+        std::chrono::steady_clock::time_point start;
+        std::promise<Result> done;
+
+        task(CNF *cnf, Valuation *va, options &&opt_);
+    };
+
+    std::deque<std::unique_ptr<task>> que;
+};
+
+}
@@ -0,0 +1,299 @@
+#include "branch.hpp"
+
+/* ========== ERWA ========== */
+
+template <bool CHB>
+ERWA<CHB>::ERWA(const int pnum_)
+    : alpha(0.4),
+      conflicts(0),
+      q(pnum_ + 1, 0),
+      assigned_at(pnum_ + 1, 0),
+      last_conflict(pnum_ + 1, 0),
+      participated(pnum_ + 1, 0),
+      reasons(pnum_ + 1, 0),
+      seg(pnum_)
+{
+}
+
+template <bool CHB>
+void ERWA<CHB>::reward(const Var v, const double r) {
+    auto &s = q[index(v)];
+    s = (1 - alpha) * s + alpha * r;
+    seg.set(v, s);
+}
+
+template <bool CHB>
+void ERWA<CHB>::assign(const Var v) {
+    seg.remove(v);
+    if constexpr (CHB) return;
+    const int x = index(v);
+    assigned_at[x] = conflicts;
+    participated[x] = 0;
+    reasons[x] = 0;
+}
+
+template <bool CHB>
+void ERWA<CHB>::unassign(const Var v) {
+    if constexpr (!CHB) {
+        const int x = index(v);
+        const auto interval = conflicts - assigned_at[x];
+        if (0 < interval) reward(v, double(participated[x] + reasons[x]) / interval);
+    }
+    seg.restore(v);
+}
+
+template <bool CHB>
+void ERWA<CHB>::analyzed(const Var v) {
+    if constexpr (CHB) last_conflict[index(v)] = conflicts + 1;
+    else participated[index(v)]++;
+}
+
+template <bool CHB>
+void ERWA<CHB>::reasoned(const Var v) {
+    reasons[index(v)]++;
+}
+
+template <bool CHB>
+void ERWA<CHB>::played(const Var v, const bool conflict) {
+    if (conflict) {
+        plays.push_back(v);
+        return;
+    }
+    reward(v, 0.9 / (conflicts - last_conflict[index(v)] + 1));
+}
+
+template <bool CHB>
+void ERWA<CHB>::conflict() {
+    conflicts++;
+    for (auto v : plays) reward(v, 1.0 / (conflicts - last_conflict[index(v)] + 1));
+    plays.clear();
+    if (0.06 < alpha) alpha -= 1e-6;
+}
+
+template <bool CHB>
+std::optional<Var> ERWA<CHB>::pickup() {
+    auto e = seg.get();
+    if (!e.active) return std::nullopt;
+    return Var(e.idx);
+}
+
+template <bool CHB>
+void ERWA<CHB>::activate(const Valuation *va) {
+    seg.activate(va);
+}
+
+template <bool CHB>
+void ERWA<CHB>::grow(const int pnum) {
+    q.resize(pnum + 1, 0);
+    assigned_at.resize(pnum + 1, 0);
+    last_conflict.resize(pnum + 1, 0);
+    participated.resize(pnum + 1, 0);
+    reasons.resize(pnum + 1, 0);
+    seg.grow(pnum);
+}
+
+template <bool CHB>
+void ERWA<CHB>::save(Writer &w) const {
+    w.put(alpha);
+    w.put(conflicts);
+    w.put(q);
+    w.put(last_conflict);
+}
+
+template <bool CHB>
+bool ERWA<CHB>::load(Reader &r) {
+    const auto n = q.size();
+    if (!r.get(alpha) || !r.get(conflicts) || !r.get(q, n) || !r.get(last_conflict, n)) return false;
+    for (std::size_t i = 1; i < n; i++) seg.set(Var(i), q[i]);
+    return true;
+}
+
+template struct ERWA<false>;
+template struct ERWA<true>;
+
+namespace {
+
+// reason side rate of LRB: the variables which implied the learnt literals
+void reward_reasons(ERWA<false> &erwa, const raw_clause &c, const Valuation *va) {
+    for (auto p : c) {
+        const auto r = va->reason(var(p));
+        if (r == nullptr) continue;
+        for (int k = 1; k < r->size(); k++) erwa.reasoned(var(r->get(k)));
+    }
+}
+
+}
+
+
+/* ========== VSIDS ========== */
+
+VSIDSBranch::VSIDSBranch(const int pnum, const branch_options &opt)
+    : vsids(pnum, opt.vsids_div, opt.vsids_span)
+{
+}
+
+void VSIDSBranch::assign(const Var v) {
+    vsids.assign(v);
+}
+
+void VSIDSBranch::unassign(const Var v) {
+    vsids.rollback(v);
+}
+
+void VSIDSBranch::learnt(const raw_clause &c, const Valuation*) {
+    vsids.vsi(c);
+}
+
+std::optional<Var> VSIDSBranch::pickup() {
+    return vsids.pickup();
+}
+
+void VSIDSBranch::grow(const int pnum) {
+    vsids.grow(pnum);
+}
+
+void VSIDSBranch::save(Writer &w) const {
+    w.put(heuristic);
+    vsids.save(w);
+}
+
+bool VSIDSBranch::load(Reader &r, const Valuation *va) {
+    Heuristic h;
+    if (!r.get(h) || h != heuristic || !vsids.load(r)) return false;
+    vsids.activate(va);
+    return true;
+}
+
+
+/* ========== LRB and CHB ========== */
+
+template <bool CHB>
+ERWABranch<CHB>::ERWABranch(const int pnum, const branch_options&)
+    : erwa(pnum)
+{
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::assign(const Var v) {
+    erwa.assign(v);
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::unassign(const Var v) {
+    erwa.unassign(v);
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::analyzed(const Var v) {
+    erwa.analyzed(v);
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::propagated(const std::vector<Literal> &lits, const int from, const int to, const bool conflict) {
+    if constexpr (!CHB) return;
+    for (int i = from; i < to; i++) erwa.played(var(lits[i]), conflict);
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::learnt(const raw_clause &c, const Valuation *va) {
+    if constexpr (!CHB) reward_reasons(erwa, c, va);
+    erwa.conflict();
+}
+
+template <bool CHB>
+std::optional<Var> ERWABranch<CHB>::pickup() {
+    return erwa.pickup();
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::grow(const int pnum) {
+    erwa.grow(pnum);
+}
+
+template <bool CHB>
+void ERWABranch<CHB>::save(Writer &w) const {
+    w.put(heuristic);
+    erwa.save(w);
+}
+
+template <bool CHB>
+bool ERWABranch<CHB>::load(Reader &r, const Valuation *va) {
+    Heuristic h;
+    if (!r.get(h) || h != heuristic || !erwa.load(r)) return false;
+    erwa.activate(va);
+    return true;
+}
+
+template struct ERWABranch<false>;
+template struct ERWABranch<true>;
+
+
+/* ========== Switch ========== */
+
+SwitchBranch::SwitchBranch(const int pnum, const branch_options &opt)
+    : use_vsids(true),
+      vsids(pnum, opt.vsids_div, opt.vsids_span),
+      erwa(pnum),
+      next_switch(10000),
+      turn(10000)
+{
+}
+
+void SwitchBranch::assign(const Var v) {
+    if (use_vsids) vsids.assign(v);
+    else erwa.assign(v);
+}
+
+void SwitchBranch::unassign(const Var v) {
+    if (use_vsids) vsids.rollback(v);
+    else erwa.unassign(v);
+}
+
+void SwitchBranch::analyzed(const Var v) {
+    if (!use_vsids) erwa.analyzed(v);
+}
+
+void SwitchBranch::learnt(const raw_clause &c, const Valuation *va) {
+    if (use_vsids) {
+        vsids.vsi(c);
+        return;
+    }
+    reward_reasons(erwa, c, va);
+    erwa.conflict();
+}
+
+std::optional<Var> SwitchBranch::pickup() {
+    return use_vsids ? vsids.pickup() : erwa.pickup();
+}
+
+void SwitchBranch::restarted(const Valuation *va, const std::uint64_t conflicts) {
+    if (conflicts < next_switch) return;
+    use_vsids = !use_vsids;
+    turn *= 2;
+    next_switch = conflicts + turn;
+    if (use_vsids) vsids.activate(va);
+    else erwa.activate(va);
+}
+
+void SwitchBranch::grow(const int pnum) {
+    vsids.grow(pnum);
+    erwa.grow(pnum);
+}
+
+void SwitchBranch::save(Writer &w) const {
+    w.put(heuristic);
+    w.put(use_vsids);
+    w.put(next_switch);
+    w.put(turn);
+    vsids.save(w);
+    erwa.save(w);
+}
+
+bool SwitchBranch::load(Reader &r, const Valuation *va) {
+    Heuristic h;
+    if (!r.get(h) || h != heuristic) return false;
+    if (!r.get(use_vsids) || !r.get(next_switch) || !r.get(turn) || !vsids.load(r) || !erwa.load(r)) return false;
+    if (use_vsids) vsids.activate(va);
+    else erwa.activate(va);
+    return true;
+}
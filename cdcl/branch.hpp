@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../cnf.hpp"
+#include "vsids.hpp"
+
+enum class Heuristic {
+    VSIDS,
+    LRB,
+    CHB,
+    Switch,  // VSIDS and LRB in turns, each turn twice as long as the previous one
+};
+
+struct branch_options {
+    Heuristic heuristic;        // chooses the solver instantiation, see cdcl::with_heuristic
+    int vsids_div, vsids_span;  // VSIDS divides every score by div once per span conflicts
+};
+
+// Learning-rate branching (Liang et al., 2016). The score Q of a variable is an
+// exponential recency weighted average of its rewards, with a step size alpha going
+// from 0.4 down to 0.06 by 1e-6 per conflict.
+// LRB : when v is unassigned, the share of the conflicts since its assignment whose
+//       analysis met v, plus the share in which v was in the reason of a learnt literal.
+// CHB : after every propagation, for each variable it assigned,
+//       0.9 (1.0 if it ended in a conflict) / (conflicts since v was met by an analysis + 1).
+template <bool CHB>
+struct ERWA {
+    ERWA() = delete;
+    ERWA(const int pnum_);
+
+    void assign(const Var v);
+    void unassign(const Var v);
+    void analyzed(const Var v);
+    void reasoned(const Var v);
+    void played(const Var v, const bool conflict);
+    void conflict();
+    std::optional<Var> pickup();
+    void activate(const Valuation *va);
+    void grow(const int pnum);
+    void save(Writer &w) const;  // the scores and the step size; the rest is reset at level 0
+    bool load(Reader &r);
+
+private:
+    double alpha;
+    std::uint64_t conflicts;
+    std::vector<double> q;
+    std::vector<std::uint64_t> assigned_at, last_conflict;
+    std::vector<int> participated, reasons;
+    std::vector<Var> plays;  // assigned by the propagation which ended in the conflict being analyzed
+    SegmentTree seg;
+
+    void reward(const Var v, const double r);
+};
+
+
+/* ========== branching policies ========== */
+
+// The branching heuristic of a solver is the branch member of its policy (see policy.hpp),
+// built from the number of variables and the branch_options of the solver. The calls
+// follow the search: every assignment and unassignment, every variable met by conflict
+// analysis, the variables assigned by each propagation (lits[from, to), the decision
+// included), the learnt clause while the reasons of its literals are still assigned, and
+// every restart at level 0. New variables of grow() start unassigned with score 0; load()
+// is false for a checkpoint of another heuristic, and va is the assignment to resume from.
+
+struct VSIDSBranch {
+    constexpr static Heuristic heuristic = Heuristic::VSIDS;
+
+    VSIDSBranch() = delete;
+    VSIDSBranch(const int pnum, const branch_options &opt);
+
+    void assign(const Var v);
+    void unassign(const Var v);
+    void analyzed(const Var) { }
+    void propagated(const std::vector<Literal>&, const int, const int, const bool) { }
+    void learnt(const raw_clause &c, const Valuation *va);
+    std::optional<Var> pickup();
+    void restarted(const Valuation*, const std::uint64_t) { }
+    void grow(const int pnum);
+    void save(Writer &w) const;
+    bool load(Reader &r, const Valuation *va);
+
+private:
+    VSIDS vsids;
+};
+
+// LRB, or CHB if CHB
+template <bool CHB>
+struct ERWABranch {
+    constexpr static Heuristic heuristic = CHB ? Heuristic::CHB : Heuristic::LRB;
+
+    ERWABranch() = delete;
+    ERWABranch(const int pnum, const branch_options &opt);
+
+    void assign(const Var v);
+    void unassign(const Var v);
+    void analyzed(const Var v);
+    void propagated(const std::vector<Literal> &lits, const int from, const int to, const bool conflict);
+    void learnt(const raw_clause &c, const Valuation *va);
+    std::optional<Var> pickup();
+    void restarted(const Valuation*, const std::uint64_t) { }
+    void grow(const int pnum);
+    void save(Writer &w) const;
+    bool load(Reader &r, const Valuation *va);
+
+private:
+    ERWA<CHB> erwa;
+};
+
+using LRBBranch = ERWABranch<false>;
+using CHBBranch = ERWABranch<true>;
+
+// VSIDS and LRB in turns, changed at the first restart after 10000, 20000, 40000, ...
+// conflicts of a turn; the only branching policy which tests its heuristic at run time.
+struct SwitchBranch {
+    constexpr static Heuristic heuristic = Heuristic::Switch;
+
+    SwitchBranch() = delete;
+    SwitchBranch(const int pnum, const branch_options &opt);
+
+    void assign(const Var v);
+    void unassign(const Var v);
+    void analyzed(const Var v);
+    void propagated(const std::vector<Literal>&, const int, const int, const bool) { }
+    void learnt(const raw_clause &c, const Valuation *va);
+    std::optional<Var> pickup();
+    void restarted(const Valuation *va, const std::uint64_t conflicts);
+    void grow(const int pnum);
+    void save(Writer &w) const;
+    bool load(Reader &r, const Valuation *va);
+
+private:
+    bool use_vsids;
+    VSIDS vsids;
+    ERWA<false> erwa;
+    std::uint64_t next_switch, turn;
+};
@@ -1,5 +1,9 @@
 #include "cdcl.hpp"
+#include "../alloc.hpp"
+#include "../checker.hpp"
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <cassert>
 #include <limits>
@@ -14,543 +18,1094 @@
 #define ASSERT(X) 42
 #endif
 
-#define CHECK
-
 namespace cdcl {
 
-void dump_watch(Clause *c) {
-    auto [fst,last]=c->get_watch();
-    std::cout<<fst<<","<<last<<std::endl;
+void dump(const raw_clause &r) {
+    for (auto e : r) std::cout << to_dimacs(e) << ' ';
+    std::cout << std::endl;
+}
+
+void dump(Clause *c) {
+    dump(c->raw());
 }
 
-int count_level(const raw_clause &r, const Valuation *va, const int level) {
+int floor_log2(std::size_t n) {
     int ret = 0;
-    for (auto e : r) {
-        if (va->decided(e) != level) continue;
+    while (1 < n) {
+        n >>= 1;
         ret++;
     }
     return ret;
 }
 
-void resolution(raw_clause &r1, const raw_clause &r2, const int p) {
-    r1.insert(std::end(r1), ALL(r2));
-    std::sort(ALL(r1));
-    r1.erase(std::unique(ALL(r1)), std::end(r1));
-    for (auto e : { p, -p }) {
-        auto ite = std::lower_bound(ALL(r1), e);
-        ASSERT(ite != std::end(r1) && *ite == e);
-        r1.erase(ite);
+bool is_tautology(const raw_clause &r) {
+    // sorted, so p and ~p are adjacent
+    for (int i = 0; i + 1 < int(r.size()); i++) {
+        if (var(r[i]) == var(r[i + 1])) return true;
     }
+    return false;
 }
 
-bool has_var(const raw_clause &r, const int p) {
-    auto ite = std::lower_bound(std::cbegin(r), std::cend(r), p);
-    return ite != std::cend(r) && *ite == p;
-}
 
-int find_max_level(const raw_clause &r, const Valuation *va, const int exclude) {
-    int ret = -1;
-    for (auto e : r) {
-        const int l = va->decided(e);
-        if (l == exclude) continue;
-        ret = std::max(ret, l);
-    }
-    return ret;
+/* ========== Trail ========== */
+
+Trail::Trail(const int pnum)
+    : head(0)
+{
+    lits.reserve(pnum);
+    lim.reserve(pnum + 1);
 }
 
-bool is_first_uip(const raw_clause &r, const Valuation *va, const int level) {
-    return count_level(r, va, level) == 1;
+void Trail::push(const Literal p) {
+    lits.push_back(p);
 }
 
-void dump(const raw_clause &r) {
-    for (auto e : r) std::cout << e << ' ';
-    std::cout << std::endl;
+void Trail::new_level() {
+    lim.push_back(lits.size());
 }
 
-void dump(Clause *c) {
-    dump(c->raw());
+int Trail::level() const {
+    return lim.size();
 }
 
+int Trail::size() const {
+    return lits.size();
+}
 
-/* ========== Logger ========== */
+int Trail::level_begin(const int dl) const {
+    return dl == 0 ? 0 : lim[dl - 1];
+}
 
-assigned_log::assigned_log(const int dl_, const int p_)
-    : dl(dl_), p(p_)
-{
+void Trail::shrink(const int dl) {
+    lits.resize(level_begin(dl + 1));
+    lim.resize(dl);
+    head = std::min(head, size());
 }
 
-Logger::Logger(const int size)
-    : clogs(size)
+
+/* ========== Watcher ========== */
+
+Watcher::Watcher(CNF *cnf)
+    : watches(2 * (cnf->get_pnum() + 1)),
+      spares(buckets),
+      traded { }
 {
 }
 
-void Logger::assign(const int dl, const int p) {
-    log_stk.emplace_back(dl, p);
+void Watcher::grow(const int pnum) {
+    watches.resize(2 * (pnum + 1));
 }
 
-void Logger::imply(const int p, Clause *c) {
-    log_stk.back().imply.emplace_back(p, c);
+void Watcher::add_watch(Clause *c) {
+    ASSERT(2 <= c->size());
+    const auto p0 = c->get(0), p1 = c->get(1);
+    push(p0, watch { c, p1 });
+    push(p1, watch { c, p0 });
 }
 
-bool Logger::is_saved(const int dl, const Clause *c) const {
-    const int idx = c->cnf_idx;
-    return clogs[idx].size() && clogs[idx].top().dl == dl;
+void Watcher::push(const Literal p, const watch w) {
+    auto &ws = watches[index(p)];
+    if (ws.size() == ws.capacity()) trade(ws);
+    ws.push_back(w);
 }
 
-void Logger::add_clause_log(const int idx, clause_log log) {
-    if (log.dl == 0) return;
-    log_stk[log.dl - 1].clog.push(idx);
-    clogs[idx].push(log);
+// swaps the storage of a full list for that of a larger spare, or lets it grow if there is none
+void Watcher::trade(std::vector<watch> &ws) {
+    const int b = floor_log2(ws.capacity()) + 1;
+    traded[b]++;
+    for (int k = b; k < int(spares.size()); k++) {
+        if (spares[k].empty()) continue;
+        auto s = std::move(spares[k].back());
+        spares[k].pop_back();
+        s.assign(ALL(ws));
+        std::swap(s, ws);
+        s.clear();
+        if (s.capacity() != 0) spares[floor_log2(s.capacity())].push_back(std::move(s));
+        return;
+    }
 }
 
-void Logger::inc_clause() {
-    clogs.emplace_back();
+void Watcher::clean() {
+    for (auto &v : watches) {
+        v.erase(std::remove_if(ALL(v), [](const watch &w) {
+            return w.c->type == ClauseType::Removed;
+        }), std::end(v));
+    }
 }
 
-assigned_log Logger::pop() {
-    auto res = std::move(log_stk.back());
-    log_stk.pop_back();
-    return res;
+void Watcher::reserve(const std::size_t n) {
+    std::size_t total = 0;
+    for (const auto &v : watches) total += v.size();
+    if (total == 0) return;
+    const double growth = 2.0 * n / total;
+    const bool first = reserved.empty();
+    reserved.resize(watches.size(), 0);
+    for (int i = 0; i < int(watches.size()); i++) {
+        auto &v = watches[i];
+        const bool outgrew = reserved[i] < v.capacity();
+        v.reserve(std::min(n, std::size_t(growth * std::max(v.capacity(), 2 * v.size()))));
+        reserved[i] = v.capacity();
+        // a list which outgrew its reserve gets a spare for its next doubling
+        if (outgrew && !first) traded[floor_log2(v.capacity()) + 1]++;
+    }
+
+    // every trade moves a spare to a smaller capacity, so a bucket takes at most as many
+    // lists as there are spares above it
+    std::size_t above = 0;
+    for (int b = int(spares.size()) - 1; 0 <= b; b--) {
+        auto &s = spares[b];
+        while (s.size() < traded[b]) {
+            s.emplace_back();
+            s.back().reserve(std::size_t(1) << b);
+        }
+        s.reserve(s.size() + above);
+        above += s.size();
+    }
+    traded.fill(0);
 }
 
-const assigned_log& Logger::top() const {
-    return log_stk.back();
+std::vector<Watcher::watch>& Watcher::get(const Literal p) {
+    return watches[index(p)];
 }
 
-assigned_log& Logger::top() {
-    return log_stk.back();
+
+/* ========== CDCL ========== */
+
+template <typename Policy>
+Solver<Policy>::Solver(CNF *cnf_, Valuation *va_)
+    : cnf(cnf_),
+      va(va_),
+      trail(cnf->get_pnum()),
+      watcher(cnf),
+      branch(cnf->get_pnum(), default_branching),
+      phases(cnf->get_pnum()),
+      walker(nullptr),
+      restarts(default_params),
+      igraph(cnf->get_pnum()),
+      stamp(cnf->get_pnum()),
+      level(0),
+      stats(statistics { }),
+      budget(limits { 0, 0 }),
+      preprocessed(false),
+      out_of_time(false),
+      inconsistent(false),
+      chrono(0),
+      check_threads(1),
+      prm(default_params),
+      perf_log(nullptr),
+      cancel(nullptr),
+      progress_interval(0),
+      export_size(0),
+      export_lbd(0),
+      checkpoint_interval(0),
+      seen(cnf->get_pnum() + 1, 0),
+      gauss(nullptr),
+      expl_conflict(nullptr)
+{
+    learnt.reserve(cnf->get_pnum() + 1);
+    kept.reserve(cnf->get_pnum());
+    if (!cnf->get_cards().empty()) init_cards();
+    if (!cnf->get_xors().empty()) gauss = new Gauss(cnf->get_xors(), cnf->get_pnum());
+    if (!cnf->get_cards().empty() || gauss != nullptr) {
+        expl.assign(cnf->get_pnum() + 1, nullptr);
+        expl_conflict = new Clause(raw_clause { });
+        expl_conflict->type = ClauseType::Explanation;
+    }
 }
 
-bool Logger::is_empty() const {
-    return log_stk.size() == 0;
+template <typename Policy>
+Solver<Policy>::~Solver() {
+    delete walker;
+    delete gauss;
+    for (auto c : expl) delete c;
+    delete expl_conflict;
 }
 
-const std::vector<assigned_log>& Logger::raw() const {
-    return log_stk;
+template <typename Policy>
+const statistics& Solver<Policy>::get_statistics() const {
+    return stats;
 }
 
-void Logger::clear() {
-    log_stk.clear();
+template <typename Policy>
+perf::Counters& Solver<Policy>::get_perf() {
+    return perf;
 }
 
-std::vector<assigned_log>& Logger::raw() {
-    return log_stk;
+template <typename Policy>
+void Solver<Policy>::set_perf_log(std::ostream *os) {
+    perf_log = os;
 }
 
+template <typename Policy>
+void Solver<Policy>::set_cancel(const std::atomic<bool> *flag) {
+    cancel = flag;
+}
 
-/* ========== Watcher ========== */
+template <typename Policy>
+void Solver<Policy>::set_progress(std::function<void(const progress&)> f, const std::uint64_t interval) {
+    on_progress = std::move(f);
+    progress_interval = interval;
+}
 
-Watcher::Watcher(CNF *cnf)
-    : warr(cnf->size()),
-      watches(cnf->get_pnum() + 1)
-{
-    for (int i = 0; i < cnf->size(); i++) {
-        auto c = cnf->get(i);
-        auto [ fst, last ] = c->get_watch();
-        const auto p0 = c->get(fst), p1 = c->get(last - 1);
-        warr[i] = std::make_pair(p0, p1);
-        add_watch(c);
-    }
+template <typename Policy>
+void Solver<Policy>::set_export(std::function<void(const raw_clause&)> f, const int size, const std::uint64_t lbd) {
+    on_export = std::move(f);
+    export_size = size;
+    export_lbd = lbd;
 }
 
-void Watcher::add_watch(Clause *c) {
-    if (c->state != ClauseState::Unknown) return;
-    auto [ fst, last ] = c->get_watch();
-    for (int i = 0; i < 2; i++) {
-        if (i == 0 && fst == last) continue;
-        if (i == 1 && last == 0) continue;
-        const auto idx = (i == 0 ? fst : last - 1);
-        const int p = std::abs(c->get(idx));
-        auto &v = watches[p];
-        const auto cnf_idx = c->cnf_idx;
-        auto ite = std::upper_bound(ALL(v), cnf_idx);
-        if (ite != std::end(v) && *ite == cnf_idx) continue;
-        v.insert(ite, cnf_idx);
-    }
+template <typename Policy>
+progress Solver<Policy>::get_progress() const {
+    return progress {
+        stats.conflicts, stats.decisions, stats.propagations, stats.restarts,
+        cnf->get_learnt_clause_num(),
+        trail.level() == 0 ? trail.size() : trail.level_begin(1),
+        phases.best_trail(),
+        cnf->get_pnum(),
+    };
 }
 
-void Watcher::remove_watch(Clause *c) {
-    auto [ fst, last ] = c->get_watch();
-    for (int i = 0; i < 2; i++) {
-        if (i == 0 && fst == last) continue;
-        if (i == 1 && last == 0) continue;
-        const auto idx = (i == 0 ? fst : last - 1);
-        const int p = std::abs(c->get(idx));
-        auto &v = watches[p];
-        const auto cnf_idx = c->cnf_idx;
-        auto ite = std::lower_bound(ALL(v), cnf_idx);
-        if (ite == std::end(v)) continue;
-        if (*ite != cnf_idx) continue;
-        v.erase(ite);
-    }
+template <typename Policy>
+void Solver<Policy>::set_branching(const branch_options &opt) {
+    ASSERT(!preprocessed && opt.heuristic == Policy::branch::heuristic);
+    branch = typename Policy::branch(cnf->get_pnum(), opt);
 }
 
-std::vector<int> Watcher::get(const int idx) const {
-    return watches[std::abs(idx)];
+template <typename Policy>
+void Solver<Policy>::set_params(const params &p) {
+    ASSERT(!preprocessed);
+    prm = p;
+    restarts = typename Policy::restart(p);
+    phases.set_interval(p.rephase_interval);
 }
 
+template <typename Policy>
+void Solver<Policy>::set_phase(const Literal p) {
+    phases.prefer(p, va);
+}
 
-/* ========== bounded_queue ========== */
+template <typename Policy>
+void Solver<Policy>::set_limits(const limits &l) {
+    budget = l;
+}
 
-bounded_queue::bounded_queue(const int bound_)
-    : bound_(bound_),
-      sum_(0),
-      g_sum_(0),
-      g_size_(0)
-{
+template <typename Policy>
+void Solver<Policy>::set_chrono(const int threshold) {
+    chrono = threshold;
 }
 
-void bounded_queue::push(const std::uint64_t v) {
-    que.push(v);
-    sum_ += v;
-    g_sum_ += v;
-    g_size_++;
-    if (bound_ < int(que.size())) pop();
+template <typename Policy>
+void Solver<Policy>::set_check_threads(const int threads) {
+    check_threads = threads;
 }
 
-void bounded_queue::pop() {
-    sum_ -= que.front();
-    que.pop();
+template <typename Policy>
+void Solver<Policy>::set_proof(std::ostream *os) {
+    proof.set_output(os);
 }
 
-void bounded_queue::clear() {
-    while (que.size()) que.pop();
+template <typename Policy>
+bool Solver<Policy>::out_of_budget() {
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) return true;
+    if (budget.conflicts != 0 && budget.conflicts <= stats.conflicts) return true;
+    if (budget.seconds == 0) return false;
+    // reading the clock is not free, so look at it every 256 conflicts
+    if (!out_of_time && stats.conflicts % 256 == 0) {
+        const std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        out_of_time = budget.seconds <= d.count();
+    }
+    return out_of_time;
 }
 
-bool bounded_queue::is_full() const noexcept {
-    return int(que.size()) == bound_;
+template <typename Policy>
+void Solver<Policy>::decision(const Var x, const PValue v) {
+    ASSERT(va->get_value(x) == PValue::BOTTOM);
+    stats.decisions++;
+    level++;
+    trail.new_level();
+    va->assign(x, v, level);
+    branch.assign(x);
+    trail.push(make_lit(x, v == PValue::FALSE));
 }
 
-std::uint64_t bounded_queue::sum() const noexcept {
-    return sum_;
+// dl is below level when p is implied out of order after a chronological backtrack
+template <typename Policy>
+void Solver<Policy>::imply(Clause *c, const Literal p, const int dl) {
+    ASSERT(c->get(0) == p);
+    ASSERT(va->get_value(p) == PValue::BOTTOM);
+    va->imply(p, dl, c);
+    branch.assign(var(p));
+    trail.push(p);
 }
 
-std::uint64_t bounded_queue::bound() const noexcept {
-    return bound_;
+// undo every assignment above the level dl
+template <typename Policy>
+void Solver<Policy>::rollback(const int dl) {
+    perf::Scope scope(perf, perf::Phase::Backtrack);
+    ASSERT(dl <= level);
+    if (trail.level() <= dl) return;
+    // literals of level <= dl implied after a chronological backtrack stay assigned
+    // and are put back in trail order; head moves below them so they are propagated again
+    kept.clear();
+    for (int i = trail.size() - 1; trail.level_begin(dl + 1) <= i; i--) {
+        const auto p = trail.lits[i];
+        if (!counted.empty()) uncount(var(p));
+        if (va->decided(p) <= dl) {
+            kept.push_back(p);
+            continue;
+        }
+        va->reset(var(p));
+        branch.unassign(var(p));
+        if (gauss != nullptr) gauss->unassigned(var(p));
+    }
+    trail.shrink(dl);
+    for (auto it = kept.rbegin(); it != kept.rend(); it++) trail.push(*it);
+    level = dl;
 }
 
-std::uint64_t bounded_queue::global_sum() const noexcept {
-    return g_sum_;
+// the counters have to follow the trail; kept literals are counted again by bcp
+template <typename Policy>
+void Solver<Policy>::uncount(const Var v) {
+    if (!counted[index(v)]) return;
+    counted[index(v)] = 0;
+    const auto p = make_lit(v, va->get_value(v) == PValue::FALSE);
+    for (int i = card_start[index(p)]; i < card_start[index(p) + 1]; i++) card_count[card_occ[i]]--;
 }
 
-std::uint64_t bounded_queue::global_size() const noexcept {
-    return g_size_;
+// the assumption p is false: the core holds p and the assumptions its negation follows from
+template <typename Policy>
+void Solver<Policy>::final_conflict(const Literal p) {
+    core.assign(1, p);
+    seen[index(var(p))] = 1;
+    for (int i = trail.size() - 1; 0 <= i; i--) {
+        const auto q = trail.lits[i];
+        const int x = index(var(q));
+        if (!seen[x]) continue;
+        seen[x] = 0;
+        if (va->decided(q) == 0) continue;
+        const auto r = va->reason(var(q));
+        if (r == nullptr) {
+            // every decision below the assumption levels is an assumption
+            core.push_back(q);
+            continue;
+        }
+        for (int k = 1; k < r->size(); k++) seen[index(var(r->get(k)))] = 1;
+    }
 }
 
+template <typename Policy>
+int Solver<Policy>::learnt_clause(Clause *conflict) {
+    learnt.clear();
+    learnt.push_back(Literal(0));
+
+    int counter = 0;
+    int idx = trail.size() - 1;
+    Clause *c = conflict;
+    std::optional<Literal> p = std::nullopt;
+    do {
+        ASSERT(c != nullptr);
+        if (c->type == ClauseType::Learnt) c->recalc_LBD(va, stamp);
+        for (int k = (p.has_value() ? 1 : 0); k < c->size(); k++) {
+            const auto q = c->get(k);
+            const int x = index(var(q));
+            const int dl = va->decided(q);
+            if (seen[x] || dl == 0) continue;
+            seen[x] = 1;
+            branch.analyzed(var(q));
+            if (dl == level) counter++;
+            else learnt.push_back(q);
+        }
+        // the trail may hold literals of lower levels above those of this one
+        while (!seen[index(var(trail.lits[idx]))] || va->decided(trail.lits[idx]) != level) idx--;
+        p = trail.lits[idx--];
+        c = va->reason(var(*p));
+        seen[index(var(*p))] = 0;
+        counter--;
+    } while (0 < counter);
+    learnt[0] = ~*p;
+
+    for (auto e : learnt) seen[index(var(e))] = 0;
+    Policy::minimize::minimize(igraph, learnt, va);
+
+    if (learnt.size() == 1) return 0;
+    int max_i = 1;
+    for (int i = 2; i < int(learnt.size()); i++) {
+        if (va->decided(learnt[max_i]) < va->decided(learnt[i])) max_i = i;
+    }
+    std::swap(learnt[1], learnt[max_i]);
+    return va->decided(learnt[1]);
+}
 
-/* ========== CDCL ========== */
+// the highest level among the literals of the conflict, which can be below level
+// when the trail is out of order
+template <typename Policy>
+int Solver<Policy>::conflict_level(Clause *conflict) const {
+    int ret = 0;
+    for (int k = 0; k < conflict->size(); k++) ret = std::max(ret, va->decided(conflict->get(k)));
+    return ret;
+}
 
-CDCL::CDCL(CNF *cnf_, Valuation *va_)
-    : cnf(cnf_),
-      va(va_),
-      logger(cnf->size()),
-      watcher(cnf),
-      vsids(cnf->get_pnum(), 10, 200),
-      lbd_que(50),
-      conflict_que(50),
-      igraph(cnf->get_pnum()),
-      g_data(global_data { 0.8, 0 }),
-      level(0)
-{
+template <typename Policy>
+void Solver<Policy>::backjump(const int dl) {
+    // chronological backtracking pays off once the search has settled (Nadel and Ryvchin, 2018)
+    if (chrono != 0 && chrono < level - dl && prm.chrono_conflicts <= stats.conflicts) rollback(level - 1);
+    else rollback(dl);
 }
 
-CDCL::~CDCL() {
+template <typename Policy>
+void Solver<Policy>::init_cards() {
+    const auto &cards = cnf->get_cards();
+    card_start.assign(2 * (cnf->get_pnum() + 1) + 1, 0);
+    for (const auto &c : cards) for (auto e : c.lits) card_start[index(e) + 1]++;
+    for (int i = 1; i < int(card_start.size()); i++) card_start[i] += card_start[i - 1];
+    card_occ.resize(card_start.back());
+    std::vector<int> pos(std::begin(card_start), std::end(card_start) - 1);
+    for (int i = 0; i < int(cards.size()); i++) {
+        for (auto e : cards[i].lits) card_occ[pos[index(e)]++] = i;
+    }
+    card_count.assign(cards.size(), 0);
+    counted.assign(cnf->get_pnum() + 1, 0);
 }
 
-void CDCL::decision(const int p, const PValue v) {
-    ASSERT(va->get_value(p) == PValue::BOTTOM);
-    level++;
-    va->assign(p, v, level);
-    vsids.assign(p);
-    igraph.decision(p);
-    logger.assign(level, p);
+// the reusable reason of v
+template <typename Policy>
+Clause* Solver<Policy>::explanation(const Var v) {
+    auto &c = expl[index(v)];
+    if (c == nullptr) {
+        c = new Clause(raw_clause { });
+        c->type = ClauseType::Explanation;
+    }
+    return c;
 }
 
-void CDCL::imply(Clause *c, const int p) {
-    ASSERT(c->state == ClauseState::Unit);
-    ASSERT(va->get_value(p) == PValue::BOTTOM);
-    va->imply(p, level);
-    vsids.assign(p);
-    igraph.imply(c, p);
-    logger.imply(p, c);
-    update_clause(c);
-    ASSERT(c->state == ClauseState::SAT);
-}
-
-void CDCL::rollback() {
-    ASSERT(!logger.is_empty());
-    auto log = std::move(logger.pop());
-    level--;
-    va->reset(log.p);
-    vsids.rollback(log.p);
-    igraph.reset_decision(log.p);
-
-    while (log.clog.size()) {
-        auto idx = log.clog.top();
-        log.clog.pop();
-        auto l = logger.clogs[idx].top();
-        logger.clogs[idx].pop();
-        auto c = cnf->get(idx);
-        watcher.remove_watch(c);
-        c->rollback(l.fst, l.last, l.state);
-        watcher.add_watch(c);
-        watcher.warr[idx] = std::make_pair(l.p0, l.p1);
-    }
-
-    for (auto [ p, c ] : log.imply) {
-        va->reset(p);
-        vsids.rollback(p);
-        igraph.reset_imply(c, p);
-    }
-}
-
-std::optional<backjump_type> CDCL::learnt_clause(raw_clause c) {
-    if (!is_first_uip(c, va, level)) {
-        const auto &implied = logger.raw().back().imply;
-        for (auto ite = std::crbegin(implied); ite != std::crend(implied); ite++) {
-            const auto [ p, unit ] = *ite;
-            ASSERT(unit != nullptr);
-            if (!has_var(c, -p)) continue;
-            resolution(c, unit->raw(), p);
-            if (is_first_uip(c, va, level)) break;
-            if (c.size() == 0) return std::nullopt;
+// Counts p in the constraints containing it. A constraint with k true literals
+// falsifies the rest, each explained by (~q | ~t1 | ... | ~tk); one with k + 1 is
+// a conflict explained by (~t1 | ... | ~tk+1).
+template <typename Policy>
+std::optional<Clause*> Solver<Policy>::propagate_cards(const Literal p) {
+    const auto &cards = cnf->get_cards();
+    const int x = index(var(p));
+    const int fst = card_start[index(p)], last = card_start[index(p) + 1];
+    if (fst == last) return std::nullopt;
+    counted[x] = 1;
+    for (int i = fst; i < last; i++) card_count[card_occ[i]]++;
+
+    for (int i = fst; i < last; i++) {
+        const int ci = card_occ[i];
+        const auto &c = cards[ci];
+        if (card_count[ci] < c.k) continue;
+
+        // the counted true literals, negated
+        learnt.clear();
+        int dl = 0;
+        for (auto q : c.lits) {
+            if (va->get_value(q) != PValue::TRUE || !counted[index(var(q))]) continue;
+            learnt.push_back(~q);
+            dl = std::max(dl, va->decided(q));
+        }
+        if (c.k < card_count[ci]) {
+            expl_conflict->raw().assign(ALL(learnt));
+            return expl_conflict;
+        }
+        for (auto q : c.lits) {
+            if (va->get_value(q) != PValue::BOTTOM) continue;
+            const auto c = explanation(var(q));
+            auto &r = c->raw();
+            r.clear();
+            r.push_back(~q);
+            r.insert(std::end(r), ALL(learnt));
+            imply(c, ~q, dl);
         }
     }
-
-    ASSERT(is_first_uip(c, va, level));
-    // igraph.recursive_minimize(c);
-    igraph.local_minimize(c, va);
-    int l = find_max_level(c, va, level);
-    Clause *clause = new Clause(std::move(c), va);
-    return std::make_tuple(clause, l);
+    return std::nullopt;
 }
 
-bool CDCL::backjump(const backjump_type bj) {
-    auto [ clause, l ] = bj;
-    auto bound = std::max(l, 0);
-    while (true) {
-        if (level == bound) break;
-        rollback();
-    }
-    if (l == -1) {
-        ASSERT(logger.is_empty());
-        ASSERT(clause->size() == 1);
-        const auto p = clause->get(0);
-        ASSERT(va->get_value(p) == PValue::BOTTOM);
-        const auto v = (p < 0 ? PValue::FALSE : PValue::TRUE); 
-        va->assign(p, v, level);
-        vsids.assign(p);
-        // logger.assign(0, p, clause);
-        // igraph.imply(clause, p);
-        return false;
-    }
-    return true;
+template <typename Policy>
+std::optional<Clause*> Solver<Policy>::propagate_xors(const Var v) {
+    return apply_gauss(gauss->assigned(v, va));
 }
 
-void CDCL::update_clause(Clause *c) {
-    const int idx = c->cnf_idx;
-    if (logger.is_saved(level, c)) {
-        watcher.remove_watch(c);
-        c->update(va, level);
-        watcher.add_watch(c);
-    } else {
-        auto [ fst, last ] = c->get_watch();
-        auto [ p0, p1 ] = watcher.warr[idx];
-        clause_log log { fst, last, level, c->state, p0, p1 };
-        logger.add_clause_log(idx, log);
-        watcher.remove_watch(c);
-        c->update(va, level);
-        watcher.add_watch(c);
-    }
-
-    if (c->state == ClauseState::Unknown) {
-        auto [ fst, last ] = c->get_watch();
-        const auto &v = c->raw();
-        watcher.warr[idx] = std::make_pair(v[fst], v[last - 1]);
-    }
-}
-
-std::optional<Clause*> CDCL::bcp(const int p) {
-    auto set = watcher.get(std::abs(p));
-    for (auto idx : set) {
-        auto [ p0, p1 ] = watcher.warr[idx];
-        auto c = cnf->get(idx);
-        if (match(p0, va->get_value(p0)) ||
-            match(p1, va->get_value(p1)))
-        {
-            auto [ fst, last ] = c->get_watch();
-            clause_log clog { fst, last, level, c->state, p0, p1 };
-            c->state = ClauseState::SAT;
-            logger.add_clause_log(idx, clog);
-            watcher.remove_watch(c);
-            continue;
-        }
-        update_clause(c);
-        if (c->state == ClauseState::UNSAT) {
-            return c;
-        } else if (c->state == ClauseState::Unit) {
-            implied.push(c);
+// imports what the last call of gauss found
+template <typename Policy>
+std::optional<Clause*> Solver<Policy>::apply_gauss(const bool ok) {
+    const auto &out = gauss->out;
+    if (!ok) {
+        expl_conflict->raw().assign(ALL(out.conflict));
+        return expl_conflict;
+    }
+    for (int i = 0; i + 1 < int(out.start.size()); i++) {
+        const auto fst = std::begin(out.lits) + out.start[i], last = std::begin(out.lits) + out.start[i + 1];
+        const auto p = *fst;
+        // another row may have implied p already, or its negation just now
+        if (va->get_value(p) == PValue::TRUE) continue;
+        if (va->get_value(p) == PValue::FALSE) {
+            expl_conflict->raw().assign(fst, last);
+            return expl_conflict;
         }
+        int dl = 0;
+        for (auto it = fst + 1; it != last; it++) dl = std::max(dl, va->decided(*it));
+        const auto c = explanation(var(p));
+        c->raw().assign(fst, last);
+        imply(c, p, dl);
     }
     return std::nullopt;
 }
 
-void CDCL::rebuild_log(Clause *c) {
-    const auto &v = c->raw();
-    const auto idx = c->cnf_idx;
-    Valuation tmp(va->get_pnum());
-    for (int dl = 1; dl <= level; dl++) {
-        auto [ fst, last ] = c->get_watch();
-        clause_log log { fst, last, dl, c->state, v[fst], v[last - 1] };
-        c->update(va, dl);
-        logger.add_clause_log(idx, log);
+template <typename Policy>
+std::optional<Clause*> Solver<Policy>::bcp() {
+    perf::Scope scope(perf, perf::Phase::Propagate);
+    while (trail.head < trail.size()) {
+        const auto p = trail.lits[trail.head++];
+        const auto f = ~p;
+        stats.propagations++;
+
+        if (!counted.empty()) {
+            if (auto conflict = propagate_cards(p)) {
+                trail.head = trail.size();
+                return conflict;
+            }
+        }
+        if (gauss != nullptr) {
+            if (auto conflict = propagate_xors(var(p))) {
+                trail.head = trail.size();
+                return conflict;
+            }
+        }
+
+        auto &ws = watcher.get(f);
+        auto i = std::begin(ws), j = i;
+        const auto end = std::end(ws);
+        while (i != end) {
+            const auto w = *i++;
+            if (va->get_value(w.blocker) == PValue::TRUE) {
+                *j++ = w;
+                continue;
+            }
+
+            auto &r = w.c->raw();
+            if (r[0] == f) std::swap(r[0], r[1]);
+            const auto first = r[0];
+            if (first != w.blocker && va->get_value(first) == PValue::TRUE) {
+                *j++ = Watcher::watch { w.c, first };
+                continue;
+            }
+
+            bool moved = false;
+            for (int k = 2; k < int(r.size()); k++) {
+                if (va->get_value(r[k]) == PValue::FALSE) continue;
+                std::swap(r[1], r[k]);
+                watcher.push(r[1], Watcher::watch { w.c, first });
+                moved = true;
+                break;
+            }
+            if (moved) continue;
+
+            if (va->get_value(first) == PValue::FALSE) {
+                *j++ = w;
+                while (i != end) *j++ = *i++;
+                ws.erase(j, end);
+                trail.head = trail.size();
+                return w.c;
+            }
+
+            // Out of order, first belongs to the highest level among the others.
+            // That literal has to be watched, so that backtracking below its level revisits c.
+            int dl = va->decided(f);
+            if (dl < level) {
+                int max_k = 1;
+                for (int k = 2; k < int(r.size()); k++) {
+                    if (va->decided(r[max_k]) < va->decided(r[k])) max_k = k;
+                }
+                dl = va->decided(r[max_k]);
+                if (max_k != 1) {
+                    std::swap(r[1], r[max_k]);
+                    watcher.push(r[1], Watcher::watch { w.c, first });
+                    imply(w.c, first, dl);
+                    continue;
+                }
+            }
+            *j++ = w;
+            imply(w.c, first, dl);
+        }
+        ws.erase(j, end);
     }
+    return std::nullopt;
 }
 
-bool CDCL::preprocess() {
+template <typename Policy>
+bool Solver<Policy>::preprocess() {
     level = 0;
-    // resolve trivial clause
     for (int i = 0; i < cnf->size(); i++) {
         auto c = cnf->get(i);
-        if (c->size() != 1) continue;
-        implied.push(c);
-    }
-
-    while (implied.size()) {
-        do {
-            auto c = implied.top();
-            implied.pop();
-            update_clause(c);
-            if (c->state == ClauseState::UNSAT) return false;
-            if (c->state == ClauseState::SAT) break;
-            ASSERT(c->state == ClauseState::Unit);
-            auto p = *(c->unit());
-            imply(c, p);
-            // if (bcp(p).has_value()) return false;
-        } while (false);
-    }
-
-    logger.clear();
-    // logger.assign(level, 0, nullptr);
-    return true;
+        if (c->size() == 0) return false;
+        if (is_tautology(c->raw())) continue;
+        if (2 <= c->size()) {
+            watcher.add_watch(c);
+            continue;
+        }
+        // trivial clause
+        const auto p = c->get(0);
+        if (va->get_value(p) == PValue::FALSE) return false;
+        if (va->get_value(p) == PValue::BOTTOM) imply(c, p, 0);
+    }
+    // constraints which no literal can tighten any further
+    for (const auto &c : cnf->get_cards()) {
+        if (c.k < 0) return false;
+        if (c.k != 0) continue;
+        for (auto q : c.lits) {
+            if (va->get_value(q) != PValue::BOTTOM) continue;
+            const auto c = explanation(var(q));
+            c->raw().assign(1, ~q);
+            imply(c, ~q, 0);
+        }
+    }
+    if (gauss != nullptr) {
+        if (gauss->is_unsat() || apply_gauss(gauss->init(va)).has_value()) return false;
+    }
+    return !bcp().has_value();
 }
 
-void CDCL::check_sat() {
-    for (int i = 0; i < cnf->size(); i++) {
-        auto c = cnf->get(i);
-        c->rollback(0, c->size(), ClauseState::Unknown);
-        c->update(va, level);
-        assert(c->state == ClauseState::SAT);
+template <typename Policy>
+void Solver<Policy>::check_sat() {
+    // learnt clauses are implied by the original ones
+    ModelChecker checker(cnf, cnf->size() - cnf->get_learnt_clause_num());
+    checker.load(va);
+    assert(!checker.find_falsified(check_threads).has_value());
+    for (int i = 1; i <= va->get_pnum(); i++) assert(int(va->get_value(Var(i))));
+    for (const auto &c : cnf->get_cards()) {
+        assert(std::count_if(ALL(c.lits), [&](const Literal p) {
+            return va->get_value(p) == PValue::TRUE;
+        }) <= c.k);
+    }
+    for (const auto &x : cnf->get_xors()) {
+        assert(std::count_if(ALL(x), [&](const Literal p) {
+            return va->get_value(p) == PValue::TRUE;
+        }) % 2 == 1);
     }
-    for (int i = 1; i <= va->get_pnum(); i++) assert(int(va->get_value(i)));
 }
 
-std::optional<Valuation*> CDCL::solve_aux() {
+template <typename Policy>
+Result Solver<Policy>::solve_aux() {
     while (true) {
-        auto pick = vsids.pickup();
+        const int from = trail.head;
+        auto conflict = bcp();
+        branch.propagated(trail.lits, from, trail.size(), conflict.has_value());
+
+        if (!conflict.has_value()) {
+            perf::Scope scope(perf, perf::Phase::Decide);
+            // the assumptions take the first levels, satisfied ones an empty level each
+            std::optional<Literal> next = std::nullopt;
+            while (level < int(assumptions.size()) && !next.has_value()) {
+                const auto p = assumptions[level];
+                const auto v = va->get_value(p);
+                if (v == PValue::FALSE) {
+                    final_conflict(p);
+                    return Result::UNSAT;
+                }
+                if (v == PValue::BOTTOM) {
+                    next = p;
+                    break;
+                }
+                level++;
+                trail.new_level();
+            }
+            if (next.has_value()) {
+                decision(var(*next), is_neg(*next) ? PValue::FALSE : PValue::TRUE);
+                continue;
+            }
+            auto pick = branch.pickup();
+            if (!pick.has_value()) {
+                return Result::SAT;
+            }
+            decision(*pick, phases.pick(*pick, va));
+            continue;
+        }
 
-        if (!pick.has_value()) {
-#ifdef CHECK
-            check_sat();
+        stats.conflicts++;
+#ifdef PERF_STATS
+        if (perf_log != nullptr && stats.conflicts % 10000 == 0) perf.report(*perf_log, stats.conflicts);
 #endif
-            return va;
+        if (progress_interval != 0 && stats.conflicts % progress_interval == 0) on_progress(get_progress());
+        perf::Scope scope(perf, perf::Phase::Analyze);
+        const auto cl = conflict_level(*conflict);
+        if (cl == 0) {
+            inconsistent = true;
+            proof.conclude();
+            return Result::UNSAT;
         }
+        phases.update(trail.lits, trail.level_begin(cl));
+        if (cl < level) rollback(cl);
 
-        while (implied.size() || pick.has_value()) {
-            auto opt = [&] -> std::optional<Clause*> {
-                if (pick.has_value()) {
-                    auto p = *pick;
-                    pick = std::nullopt;
-                    decision(p, va->get_cache(p));
-                    return bcp(p);
-                }
-                auto c = implied.top();
-                implied.pop();
-                c->recalc_LBD(va);
-                update_clause(c);
-                if (c->state == ClauseState::UNSAT) return c;
-                if (c->state == ClauseState::SAT) return std::nullopt;
-                auto p = *(c->unit());
-                imply(c, p);
-                return bcp(p);
-            }();
-            if (!opt.has_value()) continue;
-            
-            while (implied.size()) implied.pop();
-
-            const auto conflict_level = level;
-            auto bj = learnt_clause((*opt)->raw());
-            if (!bj.has_value()) return std::nullopt;
-            auto [ clause, l ] = *bj;
-            // if (l == 0) return std::nullopt;
-
-            if (!backjump(*bj)) {
-                delete clause;
-                continue;
+        const auto bl = learnt_clause(*conflict);
+        branch.learnt(learnt, va);
+        proof.add(learnt);
+        auto clause = cnf->new_learnt(learnt, va, stamp);
+        if (int(learnt.size()) <= export_size && clause->get_LBD() <= export_lbd) on_export(learnt);
+        backjump(bl);
+
+        if (2 <= clause->size()) watcher.add_watch(clause);
+        imply(clause, learnt[0], bl);
+        restarts.conflict(clause->get_LBD(), cl);
+
+        if (restarts.should_restart() || out_of_budget()) return Result::Unknown;
+    }
+}
+
+template <typename Policy>
+void Solver<Policy>::reduce() {
+    perf::Scope scope(perf, perf::Phase::Reduce);
+    const auto allocs = alloc_count();
+    // The storage of the learnt clauses up to the next reduction is reserved here, so
+    // that the conflicts until then do not allocate. Reductions wait for a restart, which
+    // can come long after the limit: there is room for twice the next limit, or for
+    // twice as many clauses past it as this reduction found past its own.
+    const auto learnts = cnf->get_learnt_clause_num();
+    const auto late = learnts - Policy::storage::limit(stats.reductions, prm);
+    auto next = Policy::storage::limit(stats.reductions + 1, prm);
+    next += std::max(next, 2 * late);
+    watcher.reserve(cnf->size() - learnts + next);
+    cnf->remove_learnt_clauses(va, prm.keep_lbd);
+    watcher.clean();
+    cnf->reserve_learnts(int(next));
+    // and walks find the walker built
+    if (walker == nullptr) walker = new SLS(cnf, cnf->size() - cnf->get_learnt_clause_num());
+    stats.reductions++;
+    if (stats.warm) {
+        stats.reduce_allocs += alloc_count() - allocs;
+    } else {
+        stats.warm = true;
+        stats.warmup_allocs = alloc_count();
+        stats.warmup_conflicts = stats.conflicts;
+    }
+}
+
+template <typename Policy>
+void Solver<Policy>::restart() {
+    rollback(0);
+    restarts.restarted();
+    stats.restarts++;
+    branch.restarted(va, stats.conflicts);
+    if (phases.should_rephase(stats.conflicts)) {
+        if (phases.rephase(va, stats.conflicts) == 'W') walk();
+        stats.rephases++;
+    }
+    if (Policy::storage::should_reduce(cnf->get_learnt_clause_num(), stats.reductions, prm)) reduce();
+    if (!checkpoint_path.empty()) {
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::duration<double> d = now - last_checkpoint;
+        if (checkpoint_interval <= d.count()) {
+            write_checkpoint();
+            last_checkpoint = now;
+        }
+    }
+}
+
+// local search over the original clauses from the saved phases, whose best
+// assignment becomes the new saved phases
+template <typename Policy>
+void Solver<Policy>::walk() {
+    if (walker == nullptr) walker = new SLS(cnf, cnf->size() - cnf->get_learnt_clause_num());
+    walker->walk(va, prm.walk_flips * cnf->get_pnum());
+    stats.walks++;
+}
+
+// The blocking clause negates the projected literals of the trail, except those which
+// their reasons derive from the literals taken before them: those follow by propagation.
+template <typename Policy>
+bool Solver<Policy>::block_model() {
+    if (projected.empty()) {
+        const auto &proj = cnf->get_projection();
+        projected.assign(cnf->get_pnum() + 1, proj.empty());
+        for (auto v : proj) projected[index(v)] = 1;
+    }
+
+    learnt.clear();
+    for (auto p : trail.lits) {
+        const int x = index(var(p));
+        if (!projected[x] || va->decided(p) == 0) continue;
+        seen[x] = 1;
+        if (const auto r = va->reason(var(p))) {
+            bool derived = true;
+            for (int k = 1; k < r->size() && derived; k++) {
+                derived = (seen[index(var(r->get(k)))] || va->decided(r->get(k)) == 0);
             }
+            if (derived) continue;
+        }
+        learnt.push_back(~p);
+    }
+    for (auto p : trail.lits) seen[index(var(p))] = 0;
+    if (learnt.empty()) return false;
+
+    auto c = new Clause(learnt);
+    cnf->add_original(c);
+    auto &r = c->raw();
+    // the two literals of the highest levels are watched
+    for (int i = 0; i < 2 && i < int(r.size()); i++) {
+        for (int j = i + 1; j < int(r.size()); j++) {
+            if (va->decided(r[i]) < va->decided(r[j])) std::swap(r[i], r[j]);
+        }
+    }
+    if (r.size() == 1) {
+        rollback(0);
+        imply(c, r[0], 0);
+        return true;
+    }
+    watcher.add_watch(c);
+    const int dl0 = va->decided(r[0]), dl1 = va->decided(r[1]);
+    if (dl1 < dl0) {
+        rollback(dl1);
+        imply(c, r[0], dl1);
+    } else {
+        rollback(dl0 - 1);
+    }
+    return true;
+}
+
+template <typename Policy>
+Result Solver<Policy>::search() {
+    return search({ });
+}
 
-            cnf->add(clause);
-            watcher.warr.emplace_back(0, 0);
-            logger.inc_clause();
-            vsids.vsi(clause);
-            conflict_que.push(conflict_level);
-            lbd_que.push(clause->get_LBD());
-            
-            // restart or not
-            if (should_restart()) goto restart_l;
-
-            rebuild_log(clause);
-            implied.push(clause);
-            ASSERT(clause->state == ClauseState::Unit);
-            ASSERT(implied.size() == 1);
-            
-            // remove or not
-            /*
-            if (20000 + 500 * g_data.removed < cnf->get_learnt_clause_num()) {
-                cnf->remove_learnt_clauses();
-                g_data.removed++;
-                // FIXME : index
+template <typename Policy>
+Result Solver<Policy>::search(const std::vector<Literal> &assumptions_) {
+    start = std::chrono::steady_clock::now();
+    out_of_time = false;
+    core.clear();
+    // a search after a model keeps going from it (see block_model) unless assumptions change the start
+    if (!assumptions.empty() || !assumptions_.empty()) rollback(0);
+    assumptions = assumptions_;
+    if (!preprocessed) {
+        preprocessed = true;
+        inconsistent = !preprocess();
+        if (inconsistent) proof.conclude();
+    }
+    if (inconsistent) return Result::UNSAT;
+    while (true) {
+        const auto res = solve_aux();
+        if (res != Result::Unknown || out_of_budget()) {
+            stats.search_allocs = alloc_count();
+            if constexpr (Policy::check) {
+                if (res == Result::SAT) check_sat();
             }
-            */
+            if (res == Result::Unknown) rollback(0);
+            return res;
         }
+        restart();
     }
+}
 
-restart_l:
-    return restart();
+template <typename Policy>
+const std::vector<Literal>& Solver<Policy>::get_core() const {
+    return core;
 }
 
-bool CDCL::should_restart() const {
-    if (!lbd_que.is_full()) return false;
+template <typename Policy>
+Var Solver<Policy>::new_var() {
+    const int n = cnf->get_pnum() + 1;
+    cnf->declare(n);
+    va->grow(n);
+    watcher.grow(n);
+    branch.grow(n);
+    phases.grow(n);
+    igraph.grow(n);
+    stamp.grow(n);
+    seen.push_back(0);
+    if (!projected.empty()) projected.push_back(cnf->get_projection().empty());
+    if (!expl.empty()) expl.push_back(nullptr);
+    if (!counted.empty()) {
+        counted.push_back(0);
+        card_start.insert(std::end(card_start), 2, card_start.back());
+    }
+    if (gauss != nullptr) gauss->grow(n);
+    return Var(n);
+}
 
-    {
-        auto v1 = double(lbd_que.sum());
-        v1 /= lbd_que.bound();
-        v1 *= g_data.K;
-        auto v2 = double(lbd_que.global_sum()) / conflict_que.global_size();
-        if (v1 > v2) return true;
+template <typename Policy>
+bool Solver<Policy>::add_clause(const raw_clause &lits) {
+    if (inconsistent) return false;
+    rollback(0);
+    auto c = new Clause(lits);
+    cnf->add_original(c);
+    // the walker is rebuilt over the new clauses
+    delete walker;
+    walker = nullptr;
+    // preprocess() watches it
+    if (!preprocessed || is_tautology(c->raw())) return true;
+    inconsistent = !attach(c);
+    return !inconsistent;
+}
+
+// Watches c, a clause added at level 0, and propagates it. Literals false at level 0 go
+// behind the others, so that they are only watched when every literal is false.
+template <typename Policy>
+bool Solver<Policy>::attach(Clause *c) {
+    auto &r = c->raw();
+    std::stable_partition(ALL(r), [&](const Literal p) { return va->get_value(p) != PValue::FALSE; });
+    if (r.empty() || va->get_value(r[0]) == PValue::FALSE) return false;
+    if (2 <= r.size()) watcher.add_watch(c);
+    if ((r.size() == 1 || va->get_value(r[1]) == PValue::FALSE) && va->get_value(r[0]) == PValue::BOTTOM) {
+        imply(c, r[0], 0);
+        return !bcp().has_value();
     }
+    return true;
+}
 
-    {
-        auto v1 = double(conflict_que.sum());
-        v1 /= conflict_que.bound();
-        auto v2 = double(conflict_que.global_sum()) / conflict_que.global_size();
-        return v1 > v2;
+
+/* ========== checkpoint ========== */
+
+namespace {
+
+constexpr std::uint32_t checkpoint_magic = 0x50434353;  // "SCCP"
+constexpr std::uint32_t checkpoint_version = 3;
+
+// splitmix64
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t hash_set(const raw_clause &r, const std::uint64_t seed) {
+    // a sum, since watching reorders the literals of a clause
+    std::uint64_t ret = mix(seed);
+    for (auto p : r) ret += mix(index(p));
+    return ret;
+}
+
+}
+
+template <typename Policy>
+std::uint64_t Solver<Policy>::fingerprint() const {
+    std::uint64_t ret = mix(cnf->get_pnum());
+    const int original = cnf->size() - cnf->get_learnt_clause_num();
+    for (int i = 0; i < original; i++) ret = mix(ret ^ hash_set(cnf->get(i)->raw(), 0));
+    for (const auto &c : cnf->get_cards()) ret = mix(ret ^ hash_set(c.lits, 1 + c.k));
+    for (const auto &x : cnf->get_xors()) ret = mix(ret ^ hash_set(x, std::uint64_t(-1)));
+    return ret;
+}
+
+template <typename Policy>
+void Solver<Policy>::save(std::ostream &out) const {
+    Writer w { out };
+    w.put(checkpoint_magic);
+    w.put(checkpoint_version);
+    w.put(cnf->get_pnum());
+    w.put(fingerprint());
+    w.put(stats);
+    w.put(Policy::restart::tag);
+
+    std::vector<PValue> saved(cnf->get_pnum() + 1, PValue::BOTTOM);
+    for (int i = 1; i <= cnf->get_pnum(); i++) saved[i] = va->get_cache(Var(i));
+    w.put(saved);
+    branch.save(w);
+    phases.save(w);
+    restarts.save(w);
+
+    std::vector<Literal> units;
+    for (auto p : trail.lits) {
+        if (va->decided(p) == 0) units.push_back(p);
+    }
+    w.put(units);
+    const int learnts = cnf->get_learnt_clause_num();
+    w.put(learnts);
+    for (int i = cnf->size() - learnts; i < cnf->size(); i++) {
+        const auto c = cnf->get(i);
+        w.put(c->get_LBD());
+        w.put(c->get_pseudo_LBD());
+        w.put(c->raw());
+    }
+}
+
+template <typename Policy>
+bool Solver<Policy>::load(std::istream &in) {
+    ASSERT(stats.conflicts == 0 && level == 0);
+    Reader r { in };
+    const int pnum = cnf->get_pnum();
+    std::uint32_t magic, version;
+    int n;
+    std::uint64_t fp;
+    if (!r.get(magic) || magic != checkpoint_magic || !r.get(version) || version != checkpoint_version) return false;
+    if (!r.get(n) || n != pnum || !r.get(fp) || fp != fingerprint()) return false;
+    if (!preprocessed) {
+        preprocessed = true;
+        inconsistent = !preprocess();
+    }
+
+    // the heuristic state is only advice, so a damaged checkpoint may leave it half loaded,
+    // but clauses are added once all of them have been read
+    statistics st;
+    char tag;
+    std::vector<PValue> saved;
+    if (!r.get(st) || !r.get(tag) || tag != Policy::restart::tag || !r.get(saved, pnum + 1)) return false;
+    if (!std::all_of(ALL(saved), is_pvalue)) return false;
+    if (!branch.load(r, va) || !phases.load(r) || !restarts.load(r)) return false;
+
+    std::vector<Literal> units;
+    int learnts;
+    if (!r.get_at_most(units, pnum) || !r.get(learnts) || learnts < 0) return false;
+    // the count is not trusted to size anything: a damaged one runs out of input instead
+    std::vector<raw_clause> clauses;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> lbd;
+    raw_clause lits;
+    for (int i = 0; i < learnts; i++) {
+        std::pair<std::uint64_t, std::uint64_t> l;
+        if (!r.get(l.first) || !r.get(l.second) || !r.get_at_most(lits, pnum)) return false;
+        clauses.push_back(lits);
+        lbd.push_back(l);
+    }
+    auto valid = [&](const Literal p) { return 1 <= index(var(p)) && index(var(p)) <= pnum; };
+    if (!std::all_of(ALL(units), valid)) return false;
+    for (const auto &c : clauses) {
+        if (!std::all_of(ALL(c), valid)) return false;
+    }
+
+    stats = st;
+    for (int i = 1; i <= pnum; i++) va->set_cache(Var(i), saved[i]);
+    for (auto p : units) clauses.push_back(raw_clause { p });
+    lbd.resize(clauses.size(), std::make_pair(1, 1));
+    for (int i = 0; i < int(clauses.size()) && !inconsistent; i++) {
+        auto c = cnf->new_learnt(clauses[i], va, stamp);
+        c->set_LBD(lbd[i].first, lbd[i].second);
+        inconsistent = !attach(c);
     }
+    return true;
+}
+
+template <typename Policy>
+void Solver<Policy>::set_checkpoint(const std::string &path, const double seconds) {
+    checkpoint_path = path;
+    checkpoint_interval = seconds;
+    last_checkpoint = std::chrono::steady_clock::now();
 }
 
-std::optional<Valuation*> CDCL::restart() {
-    while (level) {
-        ASSERT(!logger.is_empty());
-        rollback();
+template <typename Policy>
+bool Solver<Policy>::write_checkpoint() const {
+    const auto tmp = checkpoint_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        save(out);
+        if (!out.flush()) return false;
     }
-    lbd_que.clear();
-    conflict_que.clear();
-    return solve_aux();
+    return std::rename(tmp.c_str(), checkpoint_path.c_str()) == 0;
 }
 
-std::optional<Valuation*> CDCL::solve() {
-    if (!preprocess()) return std::nullopt;
-    return solve_aux();
+template <typename Policy>
+std::optional<Valuation*> Solver<Policy>::solve() {
+    if (search() != Result::SAT) return std::nullopt;
+    return va;
 }
 
+#define INSTANTIATE(P) \
+    template struct Solver<with_branch<P, VSIDSBranch>>; \
+    template struct Solver<with_branch<P, LRBBranch>>; \
+    template struct Solver<with_branch<P, CHBBranch>>; \
+    template struct Solver<with_branch<P, SwitchBranch>>;
+
+INSTANTIATE(default_policy)
+INSTANTIATE(luby_policy)
+INSTANTIATE(recursive_policy)
+INSTANTIATE(keep_policy)
+INSTANTIATE(drat_policy)
+
 } // cdcl
@@ -1,126 +1,258 @@
 #pragma once
 
 #include <variant>
-#include <queue>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <array>
 #include "../cnf.hpp"
-#include "vsids.hpp"
+#include "../perf.hpp"
+#include "branch.hpp"
 #include "graph.hpp"
+#include "phase.hpp"
+#include "gauss.hpp"
+#include "serial.hpp"
+#include "params.hpp"
+#include "policy.hpp"
+#include "../sls/sls.hpp"
 
 namespace cdcl {
 
-struct clause_log {
-    int fst, last;
-    int dl;
-    ClauseState state;
-    int p0, p1;
+enum class Result {
+    SAT,
+    UNSAT,
+    Unknown,
 };
 
-struct assigned_log {
-    int dl, p;
-    std::vector<std::pair<int, Clause*>> imply;
-    vstack<int> clog;
+struct Trail {
+    std::vector<Literal> lits;
+    std::vector<int> lim;  // lits[lim[dl - 1]] is the decision of level dl
+    int head;              // lits[head..] are not propagated yet
 
-    assigned_log(const int dl_, const int p_);
-};
-
-using backjump_type = std::tuple<Clause*, int>;
-
-struct Logger {
-    std::vector<assigned_log> log_stk;
-    std::vector<vstack<clause_log>> clogs;
-
-    Logger() = delete;
-    Logger(const int size);
-
-    void assign(const int dl, const int p);
-    void imply(const int p, Clause *c);
-    bool is_saved(const int dl, const Clause *c) const;
-    void add_clause_log(const int idx, clause_log log);
-    void inc_clause();
+    Trail() = delete;
+    Trail(const int pnum);
 
-    assigned_log pop();
-    const assigned_log& top() const;
-    assigned_log& top();
-    bool is_empty() const;
-    std::vector<assigned_log>& raw();
-    void clear();
-    const std::vector<assigned_log>& raw() const;
+    void push(const Literal p);
+    void new_level();
+    int level() const;
+    int size() const;
+    int level_begin(const int dl) const;
+    void shrink(const int dl);
 };
 
 struct Watcher {
-    std::vector<std::pair<int, int>> warr;
-    
+    struct watch {
+        Clause *c;
+        Literal blocker;  // another literal of c; c needs no visit while it is true
+    };
+
     Watcher() = delete;
     Watcher(CNF *cnf);
 
     void add_watch(Clause *c);
-    void remove_watch(Clause *c);
-    std::vector<int> get(const int idx) const;
+    void push(const Literal p, const watch w);  // p watches w.c
+    void clean();
+    // Room for the watches of n clauses: every list gets its capacity or twice its size,
+    // as the watches move between lists, grown with the clauses. A list which fills up
+    // all the same trades its storage for a larger spare one; there is a spare for every
+    // trade since the last call, and for the next doubling of every list which outgrew
+    // the room it got then.
+    void reserve(const std::size_t n);
+    void grow(const int pnum);
+    std::vector<watch>& get(const Literal p);  // clauses watching p
 
 private:
-    std::vector<std::vector<int>> watches;
+    std::vector<std::vector<watch>> watches;
+    static constexpr int buckets = 64;
+    std::vector<std::vector<std::vector<watch>>> spares;  // empty lists by log2 of their capacity
+    std::array<std::uint64_t, buckets> traded;            // trades into every bucket
+    std::vector<std::size_t> reserved;  // the capacity of every list after reserve()
+
+    void trade(std::vector<watch> &ws);
 };
 
-struct bounded_queue {
-    bounded_queue(const int bound_);
+constexpr branch_options default_branching { Heuristic::VSIDS, 10, 200 };
 
-    void push(const std::uint64_t v);
-    void pop();
-    void clear();
-    bool is_full() const noexcept;
-    std::uint64_t bound() const noexcept;
-    std::uint64_t sum() const noexcept;
-    std::uint64_t global_sum() const noexcept;
-    std::uint64_t global_size() const noexcept;
+struct limits {
+    std::uint64_t conflicts;  // 0 means no limit
+    double seconds;           // 0 means no limit
+};
 
-private:
-    const int bound_;
-    std::uint64_t sum_, g_sum_, g_size_;
-    std::queue<std::uint64_t> que;
+struct statistics {
+    std::uint64_t conflicts, decisions, propagations, restarts, reductions, rephases, walks;
+    // values of the allocation counter and of conflicts when the first reduction ended
+    // warm-up, the allocations of the later reductions, and the value of the counter when
+    // the search stopped, before the model check
+    std::uint64_t warmup_allocs, warmup_conflicts, reduce_allocs, search_allocs;
+    bool warm;
 };
 
-struct CDCL {
-    CDCL() = delete;
-    CDCL(CNF *cnf_, Valuation *va_);
-    ~CDCL();
+// a snapshot of a running search
+struct progress {
+    std::uint64_t conflicts, decisions, propagations, restarts;
+    int learnts;     // learnt clauses kept
+    int units;       // variables fixed at level 0
+    int best_trail;  // longest conflict-free trail since the last best rephase
+    int vars;
+};
+
+// The CDCL engine, compiled for the policies of Policy (see policy.hpp); its
+// instantiations are those listed there with each branching policy, and CDCL is the
+// default one.
+template <typename Policy>
+struct Solver {
+    Solver() = delete;
+    Solver(CNF *cnf_, Valuation *va_);
+    ~Solver();
 
     std::optional<Valuation*> solve();
+    // SAT, UNSAT, or Unknown when the limits are exhausted
+    Result search();
+    // Incremental use: the literals of assumptions are decided first, in order. UNSAT
+    // then comes with get_core(), the assumptions which cannot hold together, or an
+    // empty core if the clauses alone are unsatisfiable.
+    Result search(const std::vector<Literal> &assumptions_);
+    const std::vector<Literal>& get_core() const;
+    // between searches: a new variable, or a new original clause (false once the
+    // clauses are unsatisfiable)
+    Var new_var();
+    bool add_clause(const raw_clause &lits);
+    // After search() returned SAT, adds a clause excluding the current model projected
+    // onto cnf->get_projection() and backjumps, so that the next search() finds another
+    // model; learnt clauses are kept. false when no other model can exist.
+    bool block_model();
+    void set_limits(const limits &l);
+    // backjumps over more than threshold levels backtrack a single level instead; 0 disables
+    void set_chrono(const int threshold);
+    // replaces the options of the branching policy, whose heuristic opt.heuristic must
+    // name (see with_heuristic); only before solving
+    void set_branching(const branch_options &opt);
+    // replaces the numeric parameters of the search (see params.hpp); only before solving
+    void set_params(const params &p);
+    // the next decision on var(p) takes p, unless a rephase or a longer trail comes first
+    void set_phase(const Literal p);
+    // threads of the model check of Policy::check, 0 for the hardware concurrency; 1 by
+    // default, as solvers on a pool of threads are already parallel
+    void set_check_threads(const int threads);
+    const statistics& get_statistics() const;
+    perf::Counters& get_perf();
+    // with -DPERF_STATS, prints the hardware counts per phase of every 10000 conflicts to os
+    void set_perf_log(std::ostream *os);
+    // search() returns Unknown soon after *flag becomes true, which any thread may set
+    void set_cancel(const std::atomic<bool> *flag);
+    // f is called with a snapshot every interval conflicts from inside search(); 0 disables
+    void set_progress(std::function<void(const progress&)> f, const std::uint64_t interval);
+    progress get_progress() const;
+    // f is called with every learnt clause of at most size literals and LBD at most lbd,
+    // e.g. to share it with other solvers, which take it in by add_clause(); size 0 disables
+    void set_export(std::function<void(const raw_clause&)> f, const int size, const std::uint64_t lbd);
+    // Checkpoints: learnt clauses with their LBD, level-0 units, branching scores, saved,
+    // target and best phases, restart state and statistics, tied to the original clauses.
+    // save() works between searches and at any level; load() only before the first
+    // search, and is false for a checkpoint of another formula, heuristic or restart policy.
+    void save(std::ostream &out) const;
+    bool load(std::istream &in);
+    // every restart after seconds since the last one writes a checkpoint to path
+    void set_checkpoint(const std::string &path, const double seconds);
+    bool write_checkpoint() const;  // to the path of set_checkpoint, replacing it atomically
+    // where a proof policy writes the proof of the search, see DratProof
+    void set_proof(std::ostream *os);
 
 private:
     CNF *cnf;
     Valuation *va;
-    Logger logger;
+    Trail trail;
     Watcher watcher;
-    VSIDS vsids;
-    bounded_queue lbd_que, conflict_que;
+    typename Policy::branch branch;
+    Phases phases;
+    SLS *walker;  // built at the first walk rephase
+    typename Policy::restart restarts;
+    typename Policy::proof proof;
     ImplicationGraph igraph;
-
-    struct global_data {
-        double K;
-        std::uint64_t removed;
-    } g_data;
+    LevelStamp stamp;
 
     int level;
-    vstack<Clause*> implied;
+    statistics stats;
+    limits budget;
+    std::chrono::steady_clock::time_point start;
+    bool preprocessed, out_of_time;
+    bool inconsistent;  // unsatisfiable at level 0
+    std::vector<Literal> assumptions, core;
+    int chrono;
+    int check_threads;
+    params prm;
+    perf::Counters perf;
+    std::ostream *perf_log;
+    const std::atomic<bool> *cancel;
+    std::function<void(const progress&)> on_progress;
+    std::uint64_t progress_interval;
+    std::function<void(const raw_clause&)> on_export;
+    int export_size;
+    std::uint64_t export_lbd;
+    std::string checkpoint_path;
+    double checkpoint_interval;
+    std::chrono::steady_clock::time_point last_checkpoint;
+
+    // scratch buffers of conflict analysis, reused across conflicts
+    raw_clause learnt;
+    std::vector<char> seen;
+    std::vector<char> projected;  // built by the first block_model()
+    std::vector<Literal> kept;  // out-of-order literals which survive a rollback
+
+    // Cardinality constraints: cnf->get_cards()[i] contains literal p for every i in
+    // card_occ[card_start[p] .. card_start[p + 1]). card_count counts the true literals
+    // which bcp has seen (counted).
+    std::vector<int> card_occ, card_start, card_count;
+    std::vector<char> counted;
+    Gauss *gauss;  // XOR constraints, nullptr without them
+    // An implication or a conflict of a cardinality or XOR constraint is explained by
+    // a clause built into expl[var] or expl_conflict, reused every time.
+    std::vector<Clause*> expl;
+    Clause *expl_conflict;
 
-    void decision(const int p, const PValue v);
-    void imply(Clause *c, const int p);
- 
-    void rollback();
-    std::optional<Clause*> bcp(const int p);
+    void decision(const Var x, const PValue v);
+    void imply(Clause *c, const Literal p, const int dl);
 
-    bool backjump(const backjump_type bj);
-    std::optional<backjump_type> learnt_clause(raw_clause c);
+    void rollback(const int dl);
+    std::optional<Clause*> bcp();
+    std::optional<Clause*> propagate_cards(const Literal p);
+    std::optional<Clause*> propagate_xors(const Var v);
+    std::optional<Clause*> apply_gauss(const bool ok);
+    Clause* explanation(const Var v);
+    void uncount(const Var v);
 
-    void update_clause(Clause *c);
-    void rebuild_log(Clause *c);
+    bool attach(Clause *c);
+    std::uint64_t fingerprint() const;
 
-    std::optional<Valuation*> restart();
-    bool should_restart() const;
+    void backjump(const int dl);
+    int conflict_level(Clause *conflict) const;
+    int learnt_clause(Clause *conflict);
+    void final_conflict(const Literal p);
 
+    void restart();
+    void walk();
+    void reduce();
+    bool out_of_budget();
+
+    void init_cards();
     bool preprocess();
-    std::optional<Valuation*> solve_aux();
+    Result solve_aux();
     void check_sat();
 };
 
+using CDCL = Solver<default_policy>;
+
+// Returns f(with_branch<Policy, B> { }) for the branching policy B of heuristic, so that
+// f builds the solver of a heuristic chosen at run time; the choice is made once here
+// instead of at every assignment of the search.
+template <typename Policy, typename F>
+auto with_heuristic(const Heuristic heuristic, F &&f) {
+    switch (heuristic) {
+        case Heuristic::LRB: return f(with_branch<Policy, LRBBranch> { });
+        case Heuristic::CHB: return f(with_branch<Policy, CHBBranch> { });
+        case Heuristic::Switch: return f(with_branch<Policy, SwitchBranch> { });
+        default: return f(with_branch<Policy, VSIDSBranch> { });
+    }
+}
+
 }
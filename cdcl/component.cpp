@@ -0,0 +1,256 @@
+#include "component.hpp"
+#include <algorithm>
+#include <thread>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+namespace cdcl {
+
+namespace {
+
+PValue value_of(const std::vector<PValue> &fixed, const Literal p) {
+    const auto v = fixed[index(var(p))];
+    return is_neg(p) ? PValue(-int(v)) : v;
+}
+
+// union-find over the variables, with path halving
+struct DisjointSet {
+    std::vector<int> parent;
+
+    DisjointSet(const int n) : parent(n) {
+        for (int i = 0; i < n; i++) parent[i] = i;
+    }
+
+    int find(int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    }
+
+    void unite(const raw_clause &r) {
+        for (int i = 1; i < int(r.size()); i++) parent[find(index(var(r[i])))] = find(index(var(r[0])));
+    }
+};
+
+void add(statistics &dst, const statistics &src) {
+    dst.conflicts += src.conflicts;
+    dst.decisions += src.decisions;
+    dst.propagations += src.propagations;
+    dst.restarts += src.restarts;
+    dst.reductions += src.reductions;
+    dst.rephases += src.rephases;
+    dst.walks += src.walks;
+}
+
+}
+
+Components::Components(CNF *cnf_)
+    : cnf(cnf_),
+      unsat(false),
+      fixed(cnf->get_pnum() + 1, PValue::BOTTOM),
+      stats(statistics { })
+{
+    unsat = !propagate();
+    if (!unsat) split();
+}
+
+int Components::size() const {
+    return comps.size();
+}
+
+const statistics& Components::get_statistics() const {
+    return stats;
+}
+
+// unit propagation over the original clauses; false on a conflict
+bool Components::propagate() {
+    const int original = cnf->size() - cnf->get_learnt_clause_num();
+    std::vector<std::vector<int>> occ(2 * (cnf->get_pnum() + 1));
+    std::vector<Literal> que;
+    auto assign = [&](const Literal p) {
+        const auto v = value_of(fixed, p);
+        if (v == PValue::BOTTOM) {
+            fixed[index(var(p))] = is_neg(p) ? PValue::FALSE : PValue::TRUE;
+            que.push_back(p);
+        }
+        return v != PValue::FALSE;
+    };
+
+    for (int i = 0; i < original; i++) {
+        const auto &r = cnf->get(i)->raw();
+        if (r.empty()) return false;
+        for (auto e : r) occ[index(e)].push_back(i);
+        if (r.size() == 1 && !assign(r[0])) return false;
+    }
+    for (int qi = 0; qi < int(que.size()); qi++) {
+        for (auto i : occ[index(~que[qi])]) {
+            int free = 0;
+            Literal last = Literal(0);
+            bool sat = false;
+            for (auto e : cnf->get(i)->raw()) {
+                const auto v = value_of(fixed, e);
+                if (v == PValue::TRUE) sat = true;
+                if (v != PValue::BOTTOM) continue;
+                free++;
+                last = e;
+            }
+            if (sat || 2 <= free) continue;
+            if (free == 0 || !assign(last)) return false;
+        }
+    }
+    return true;
+}
+
+// simplifies every constraint by the fixed variables and groups what is left
+void Components::split() {
+    const int pnum = cnf->get_pnum();
+    const int original = cnf->size() - cnf->get_learnt_clause_num();
+    DisjointSet ds(pnum + 1);
+    auto unassigned = [&](const raw_clause &r) {
+        raw_clause ret;
+        for (auto e : r) {
+            if (value_of(fixed, e) == PValue::BOTTOM) ret.push_back(e);
+        }
+        return ret;
+    };
+    auto count_true = [&](const raw_clause &r) {
+        return int(std::count_if(ALL(r), [&](const Literal p) { return value_of(fixed, p) == PValue::TRUE; }));
+    };
+
+    std::vector<raw_clause> clauses, xors;
+    std::vector<AtMost> cards;
+    for (int i = 0; i < original; i++) {
+        const auto &r = cnf->get(i)->raw();
+        if (count_true(r) != 0) continue;
+        clauses.push_back(unassigned(r));
+        ds.unite(clauses.back());
+    }
+    for (const auto &c : cnf->get_cards()) {
+        AtMost a { unassigned(c.lits), c.k - count_true(c.lits) };
+        if (a.k < 0) {
+            unsat = true;
+            return;
+        }
+        if (int(a.lits.size()) <= a.k) continue;
+        ds.unite(a.lits);
+        cards.push_back(std::move(a));
+    }
+    for (const auto &x : cnf->get_xors()) {
+        auto r = unassigned(x);
+        // the XOR of the rest has to be true iff that of the true literals is false
+        const bool flip = count_true(x) % 2 == 1;
+        if (r.empty()) {
+            if (!flip) {
+                unsat = true;
+                return;
+            }
+            continue;
+        }
+        if (flip) r[0] = ~r[0];
+        ds.unite(r);
+        xors.push_back(std::move(r));
+    }
+
+    // component of each root, and the number of each variable in its component
+    std::vector<int> comp_of(pnum + 1, -1), local(pnum + 1, 0);
+    auto get = [&](const Var v) -> component& {
+        auto &id = comp_of[ds.find(index(v))];
+        if (id == -1) {
+            id = comps.size();
+            comps.emplace_back();
+        }
+        auto &c = comps[id];
+        if (local[index(v)] == 0) {
+            c.vars.push_back(v);
+            local[index(v)] = c.vars.size();
+        }
+        return c;
+    };
+    auto rename = [&](raw_clause r) {
+        for (auto &e : r) e = make_lit(Var(local[index(var(e))]), is_neg(e));
+        return r;
+    };
+    auto owner = [&](const raw_clause &r) -> component& {
+        for (int i = 1; i < int(r.size()); i++) get(var(r[i]));
+        return get(var(r[0]));
+    };
+    for (auto &r : clauses) {
+        auto &c = owner(r);
+        c.clauses.push_back(rename(std::move(r)));
+    }
+    for (auto &a : cards) {
+        auto &c = owner(a.lits);
+        c.cards.push_back(AtMost { rename(std::move(a.lits)), a.k });
+    }
+    for (auto &x : xors) {
+        auto &c = owner(x);
+        c.xors.push_back(rename(std::move(x)));
+    }
+    // the largest first, so that it does not start last on the pool
+    std::stable_sort(ALL(comps), [](const component &a, const component &b) {
+        return b.vars.size() < a.vars.size();
+    });
+}
+
+Result Components::solve_one(component &c, Valuation *va, const component_options &opt,
+                             const std::atomic<bool> *stop) {
+    CNF sub(std::move(c.clauses), std::move(c.cards), std::move(c.xors));
+    sub.declare(c.vars.size());
+    Valuation sva(sub.get_pnum());
+    Result res;
+    statistics st;
+    with_heuristic<default_policy>(opt.branching.heuristic, [&](auto p) {
+        Solver<decltype(p)> solver(&sub, &sva);
+        solver.set_limits(opt.lim);
+        solver.set_chrono(opt.chrono);
+        solver.set_branching(opt.branching);
+        solver.set_params(opt.search);
+        solver.set_cancel(stop);
+        res = solver.search();
+        st = solver.get_statistics();
+    });
+    // components own disjoint variables of va, so the threads never write the same one
+    if (res == Result::SAT) {
+        for (int i = 0; i < int(c.vars.size()); i++) va->assign(c.vars[i], sva.get_value(Var(i + 1)), 0);
+    }
+    sub.free();
+    std::lock_guard<std::mutex> lock(mtx);
+    add(stats, st);
+    return res;
+}
+
+Result Components::solve(Valuation *va, const component_options &opt) {
+    if (unsat) return Result::UNSAT;
+    int threads = (opt.threads == 0 ? int(std::thread::hardware_concurrency()) : opt.threads);
+    threads = std::max(1, std::min(threads, size()));
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> next(0);
+    std::vector<Result> results(comps.size(), Result::Unknown);
+    auto worker = [&] {
+        while (true) {
+            const int i = next.fetch_add(1);
+            if (size() <= i || stop) return;
+            results[i] = solve_one(comps[i], va, opt, &stop);
+            if (results[i] == Result::UNSAT) stop = true;
+        }
+    };
+    if (threads == 1) {
+        worker();
+    } else {
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+        for (auto &t : pool) t.join();
+    }
+
+    if (std::count(ALL(results), Result::UNSAT)) return Result::UNSAT;
+    if (std::count(ALL(results), Result::Unknown)) return Result::Unknown;
+    // fixed variables take their value, those of no constraint any
+    for (int i = 1; i <= cnf->get_pnum(); i++) {
+        if (fixed[i] != PValue::BOTTOM) va->assign(Var(i), fixed[i], 0);
+        else if (va->get_value(Var(i)) == PValue::BOTTOM) va->assign(Var(i), PValue::FALSE, 0);
+    }
+    return Result::SAT;
+}
+
+}
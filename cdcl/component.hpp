@@ -0,0 +1,51 @@
+#pragma once
+
+#include <mutex>
+#include "cdcl.hpp"
+
+namespace cdcl {
+
+struct component_options {
+    int threads;  // 0 picks the hardware concurrency
+    limits lim;   // per component
+    int chrono;
+    branch_options branching;
+    params search;
+};
+
+// Splits the original constraints into variable-disjoint components and solves each
+// with its own CDCL on a pool of threads, so that the restarts and branching scores
+// of one never disturb another. The units of the clauses are propagated first, which
+// drops satisfied clauses and false literals, so that they no longer join components.
+// The first UNSAT component cancels the others.
+struct Components {
+    Components() = delete;
+    Components(CNF *cnf_);
+
+    int size() const;  // number of components, 0 when propagation alone decides
+    // SAT leaves the merged model in va, whose variables are all assigned; only once,
+    // as the components are moved into their solvers
+    Result solve(Valuation *va, const component_options &opt);
+    const statistics& get_statistics() const;  // summed over the components
+
+private:
+    struct component {
+        std::vector<Var> vars;  // variable i + 1 of the component is vars[i]
+        std::vector<raw_clause> clauses;
+        std::vector<AtMost> cards;
+        std::vector<raw_clause> xors;
+    };
+
+    CNF *cnf;
+    bool unsat;  // found by propagation or by simplifying a constraint away
+    std::vector<PValue> fixed;
+    std::vector<component> comps;
+    statistics stats;
+    std::mutex mtx;  // guards stats
+
+    bool propagate();
+    void split();
+    Result solve_one(component &c, Valuation *va, const component_options &opt, const std::atomic<bool> *stop);
+};
+
+}
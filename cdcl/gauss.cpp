@@ -0,0 +1,241 @@
+#include "gauss.hpp"
+#include <algorithm>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+Gauss::Gauss(const std::vector<raw_clause> &xors, const int pnum)
+    : rows(0),
+      cols(0),
+      unsat(false),
+      var_col(pnum + 1, -1)
+{
+    for (const auto &x : xors) {
+        for (auto p : x) {
+            auto &c = var_col[index(var(p))];
+            if (c != -1) continue;
+            c = cols++;
+            col_var.push_back(var(p));
+        }
+    }
+    words = (cols + 63) / 64;
+    rows = xors.size();
+    mat.assign(std::size_t(rows) * words, 0);
+    rhs.assign(rows, 0);
+    for (int r = 0; r < rows; r++) {
+        char b = 1;
+        for (auto p : xors[r]) {
+            const int c = var_col[index(var(p))];
+            // x ^ x = 0 and ~x = x ^ 1
+            mat[std::size_t(r) * words + c / 64] ^= std::uint64_t(1) << (c % 64);
+            b ^= char(is_neg(p));
+        }
+        rhs[r] = b;
+    }
+
+    // Gauss-Jordan elimination; rows without any column are dropped
+    basic_row.assign(cols, -1);
+    int n = 0;
+    for (int r = 0; r < rows; r++) {
+        if (r != n) {
+            std::copy_n(&mat[std::size_t(r) * words], words, &mat[std::size_t(n) * words]);
+            rhs[n] = rhs[r];
+        }
+        for (int r2 = 0; r2 < n; r2++) {
+            if (test(n, basic[r2])) xor_row(n, r2);
+        }
+        int c = -1;
+        for (int w = 0; w < words && c == -1; w++) {
+            const auto x = mat[std::size_t(n) * words + w];
+            if (x != 0) c = w * 64 + __builtin_ctzll(x);
+        }
+        if (c == -1) {
+            unsat |= bool(rhs[n]);
+            continue;
+        }
+        for (int r2 = 0; r2 < n; r2++) {
+            if (test(r2, c)) xor_row(r2, n);
+        }
+        basic.push_back(c);
+        basic_row[c] = n++;
+    }
+    rows = n;
+    mat.resize(std::size_t(rows) * words);
+    rhs.resize(rows);
+    watch.assign(rows, -1);
+    watches.resize(cols);
+    is_pending.assign(rows, 0);
+}
+
+bool Gauss::is_unsat() const {
+    return unsat;
+}
+
+bool Gauss::test(const int r, const int c) const {
+    return (mat[std::size_t(r) * words + c / 64] >> (c % 64)) & 1;
+}
+
+void Gauss::xor_row(const int dst, const int src) {
+    auto d = &mat[std::size_t(dst) * words];
+    const auto s = &mat[std::size_t(src) * words];
+    for (int w = 0; w < words; w++) d[w] ^= s[w];
+    rhs[dst] ^= rhs[src];
+}
+
+// makes c the basic column of r
+void Gauss::pivot(const int r, const int c) {
+    for (int r2 = 0; r2 < rows; r2++) {
+        if (r2 == r || !test(r2, c)) continue;
+        xor_row(r2, r);
+        dirty.push_back(r2);
+    }
+    basic_row[basic[r]] = -1;
+    basic[r] = c;
+    basic_row[c] = r;
+}
+
+void Gauss::set_watch(const int r, const int c) {
+    if (watch[r] == c) return;
+    watch[r] = c;
+    if (c != -1) watches[c].push_back(r);
+}
+
+Gauss::scan_result Gauss::scan(const int r, const Valuation *va) const {
+    scan_result ret { -1, -1, false };
+    int last_dl = -1;
+    const auto row = &mat[std::size_t(r) * words];
+    for (int w = 0; w < words; w++) {
+        auto x = row[w];
+        while (x != 0) {
+            const int c = w * 64 + __builtin_ctzll(x);
+            x &= x - 1;
+            if (c == basic[r]) continue;
+            const auto v = va->get_value(col_var[c]);
+            if (v == PValue::BOTTOM) {
+                ret.free = c;
+                return ret;
+            }
+            ret.parity ^= (v == PValue::TRUE);
+            if (last_dl < va->decided(col_var[c])) {
+                last_dl = va->decided(col_var[c]);
+                ret.last = c;
+            }
+        }
+    }
+    return ret;
+}
+
+Literal Gauss::lit(const int c, const bool value) const {
+    return make_lit(col_var[c], !value);
+}
+
+Literal Gauss::falsified(const int c, const Valuation *va) const {
+    return lit(c, va->get_value(col_var[c]) == PValue::FALSE);
+}
+
+// watches an unassigned column of r, or implies its basic variable or detects a
+// conflict once no other column is unassigned
+bool Gauss::check_row(const int r, const Valuation *va) {
+    const auto s = scan(r, va);
+    if (s.free != -1) {
+        set_watch(r, s.free);
+        return true;
+    }
+    set_watch(r, s.last);
+
+    const int b = basic[r];
+    const bool want = bool(rhs[r]) ^ s.parity;
+    const auto vb = va->get_value(col_var[b]);
+    if (vb != PValue::BOTTOM && (vb == PValue::TRUE) == want) return true;
+
+    auto &dst = (vb == PValue::BOTTOM ? out.lits : out.conflict);
+    dst.push_back(vb == PValue::BOTTOM ? lit(b, want) : falsified(b, va));
+    const auto row = &mat[std::size_t(r) * words];
+    for (int w = 0; w < words; w++) {
+        for (auto x = row[w]; x != 0; x &= x - 1) {
+            const int c = w * 64 + __builtin_ctzll(x);
+            if (c != b) dst.push_back(falsified(c, va));
+        }
+    }
+    if (vb != PValue::BOTTOM) return false;
+    out.start.push_back(out.lits.size());
+    return true;
+}
+
+void Gauss::begin() {
+    out.lits.clear();
+    out.start.assign(1, 0);
+    out.conflict.clear();
+    dirty.clear();
+}
+
+void Gauss::grow(const int pnum) {
+    var_col.resize(pnum + 1, -1);
+}
+
+void Gauss::unassigned(const Var v) {
+    const int c = var_col[index(v)];
+    if (c == -1) return;
+    for (auto r : watches[c]) {
+        if (watch[r] != c || is_pending[r]) continue;
+        is_pending[r] = 1;
+        pending.push_back(r);
+    }
+}
+
+// restores "the basic variable is unassigned unless the whole row is" for the queued rows
+bool Gauss::repivot(const Valuation *va) {
+    bool ok = true;
+    for (auto r : pending) {
+        is_pending[r] = 0;
+        if (!ok || va->get_value(col_var[basic[r]]) == PValue::BOTTOM) continue;
+        const auto s = scan(r, va);
+        if (s.free == -1) continue;
+        dirty.clear();
+        pivot(r, s.free);
+        ok = check_row(r, va);
+        for (auto r2 : dirty) {
+            if (!ok) break;
+            ok = check_row(r2, va);
+        }
+    }
+    pending.clear();
+    dirty.clear();
+    return ok;
+}
+
+bool Gauss::init(const Valuation *va) {
+    begin();
+    bool ok = true;
+    for (int r = 0; r < rows && ok; r++) ok = check_row(r, va);
+    return ok;
+}
+
+bool Gauss::assigned(const Var v, const Valuation *va) {
+    begin();
+    if (!pending.empty() && !repivot(va)) return false;
+    const int c = var_col[index(v)];
+    if (c == -1) return true;
+
+    bool ok = true;
+    if (const int r = basic_row[c]; r != -1) {
+        const auto s = scan(r, va);
+        if (s.free != -1) pivot(r, s.free);
+        ok = check_row(r, va);
+        for (auto r2 : dirty) {
+            if (!ok) break;
+            ok = check_row(r2, va);
+        }
+    }
+
+    // the rows watching c, compacted in place
+    auto &ws = watches[c];
+    auto j = std::begin(ws);
+    for (auto i = std::begin(ws); i != std::end(ws); i++) {
+        const int r = *i;
+        if (watch[r] != c) continue;
+        if (ok) ok = check_row(r, va);
+        if (watch[r] == c) *j++ = r;
+    }
+    ws.erase(j, std::end(ws));
+    return ok;
+}
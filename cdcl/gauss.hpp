@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include "../cnf.hpp"
+
+// XOR constraints as a bit-packed matrix kept in reduced row echelon form by
+// incremental Gauss-Jordan elimination (Han and Jiang, 2012).
+// Every row has a basic column which no other row contains, and watches one of its
+// other columns: an unassigned one if there is any, else the one assigned at the
+// highest level, which backtracking frees first. Once the basic variable is assigned,
+// the row is pivoted onto an unassigned column by XORing it, 64 columns at a time,
+// into every other row holding that column. Row operations keep the system
+// equivalent, so nothing has to be undone on backtracking, except that a row whose
+// basic variable stays assigned while its watch is freed has to be pivoted again;
+// those rows are queued and pivoted by the next call.
+struct Gauss {
+    Gauss() = delete;
+    // xors[i] holds the literals whose XOR is true
+    Gauss(const std::vector<raw_clause> &xors, const int pnum);
+
+    bool is_unsat() const;  // the elimination derived 0 = 1
+
+    // Both return false on a conflict. Found implications and the conflict are in out.
+    bool init(const Valuation *va);                   // checks every row
+    bool assigned(const Var v, const Valuation *va);  // v has just been assigned
+    void unassigned(const Var v);                     // v is being reset by a backtrack
+    void grow(const int pnum);                        // variables added after construction
+
+    // Reasons of the implications, back to back: lits[start[i] .. start[i + 1]) with the
+    // implied literal first and the falsified literals of the rest of its row after it.
+    struct output {
+        std::vector<Literal> lits;
+        std::vector<int> start;
+        raw_clause conflict;  // every literal is false
+    } out;
+
+private:
+    int rows, cols, words;
+    bool unsat;
+    std::vector<std::uint64_t> mat;  // row r is mat[r * words .. (r + 1) * words)
+    std::vector<char> rhs;
+    std::vector<Var> col_var;
+    std::vector<int> var_col;  // -1 if the variable is in no XOR
+    std::vector<int> basic, basic_row, watch;
+    std::vector<std::vector<int>> watches;  // rows which watch a column; stale entries are dropped lazily
+    std::vector<int> dirty;
+    std::vector<int> pending;
+    std::vector<char> is_pending;
+
+    struct scan_result {
+        int free, last;  // an unassigned non-basic column, the one assigned last
+        bool parity;     // XOR of the assigned non-basic columns
+    };
+
+    bool test(const int r, const int c) const;
+    void xor_row(const int dst, const int src);
+    void pivot(const int r, const int c);
+    void set_watch(const int r, const int c);
+    scan_result scan(const int r, const Valuation *va) const;
+    bool check_row(const int r, const Valuation *va);
+    Literal lit(const int c, const bool value) const;
+    Literal falsified(const int c, const Valuation *va) const;
+    void begin();
+    bool repivot(const Valuation *va);
+};
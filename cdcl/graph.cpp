@@ -1,110 +1,89 @@
 #include "graph.hpp"
 #include <cassert>
-#include <cmath>
 #include <iostream>
 
 #define ALL(V) std::begin(V), std::end(V)
 
 ImplicationGraph::ImplicationGraph(const int pnum)
-    : redges(pnum + 1),
-      mark(pnum + 1),
-      cache(pnum + 1),
-      decision_v(pnum + 1)
+    : mark(pnum + 1),
+      cache(pnum + 1)
 {
+    touched.reserve(pnum);
+    stk.reserve(pnum);
 }
 
-void ImplicationGraph::imply(const Clause *c, const int p) {
-    auto &v = redges[std::abs(p)];
-    for (auto e : c->raw()) {
-        if (e == p) continue;
-        v.push_back(std::abs(e));
-    }
+void ImplicationGraph::grow(const int pnum) {
+    mark.resize(pnum + 1);
+    cache.resize(pnum + 1);
 }
 
-void ImplicationGraph::decision(const int p) {
-    decision_v[std::abs(p)] = 1;
-}
+void ImplicationGraph::local_minimize(raw_clause &r, const Valuation *va) {
+    for (auto e : r) mark[index(var(e))] = 1;
 
-namespace {
-void dump(const std::vector<int> &v) {
-    for(auto e:v)std::cout<<e<<",";
-    std::cout<<std::endl;
-}
+    for (int i = 1; i < int(r.size()); i++) {
+        const auto c = va->reason(var(r[i]));
+        if (c == nullptr) continue;
+        bool ok = true;
+        for (int k = 1; k < c->size() && ok; k++) {
+            const auto f = c->get(k);
+            ok = mark[index(var(f))] || va->decided(f) == 0;
+        }
+        if (ok) cache[index(var(r[i]))] = ok_bit;
+    }
+
+    compact(r);
 }
 
-void ImplicationGraph::reset_imply(const Clause *c, const int p) {
-    auto &v = redges[std::abs(p)];
-    const auto &raw = c->raw();
-    for (auto ite = std::crbegin(raw); ite != std::crend(raw); ite++) {
-        if (*ite == p) continue;
-        assert(v.back() == std::abs(*ite));
-        v.pop_back();
+void ImplicationGraph::recursive_minimize(raw_clause &r, const Valuation *va) {
+    for (auto e : r) mark[index(var(e))] = 1;
+
+    for (int i = 1; i < int(r.size()); i++) {
+        if (va->reason(var(r[i])) != nullptr) traverse(var(r[i]), va);
     }
-}
 
-void ImplicationGraph::reset_decision(const int p) {
-    assert(decision_v[std::abs(p)]);
-    decision_v[std::abs(p)] = 0;
+    compact(r);
+    for (auto v : touched) cache[index(v)] = 0;
+    touched.clear();
 }
 
-void ImplicationGraph::local_minimize(raw_clause &r, const Valuation *va) {
-    for (auto e : r) mark[std::abs(e)] = 1;
-    
-    raw_clause buf = r;
-    r.clear();
-    for (auto e : buf) {
-        bool ok = [&] {
-            if (decision_v[std::abs(e)]) return false;
-            for (auto f : redges[std::abs(e)]) {
-                if (!mark[f]) return false;
-                if (va->decided(std::abs(e)) != va->decided(f)) return false;
-            }
-            return true;
-        }();
-        if (!ok) r.push_back(e);
+// drops the literals whose ok_bit is set and clears the marks
+void ImplicationGraph::compact(raw_clause &r) {
+    mark[index(var(r[0]))] = 0;
+    int j = 1;
+    for (int i = 1; i < int(r.size()); i++) {
+        const int x = index(var(r[i]));
+        mark[x] = 0;
+        if (cache[x] & ok_bit) cache[x] = 0;
+        else r[j++] = r[i];
     }
-    
-    for (auto e : buf) mark[std::abs(e)] = 0;
+    r.resize(j);
 }
 
-void ImplicationGraph::recursive_minimize(raw_clause &r) {
-    std::fill(ALL(cache), 0);
-    for (auto e : r) mark[std::abs(e)] = 1;
-    
-    auto buf = r;
-    r.clear();
-    for (auto e : buf) {
-        if (decision_v[std::abs(e)]) {
-            r.push_back(e);
+// true if every path from root back to a decision passes through a marked literal
+bool ImplicationGraph::traverse(const Var root, const Valuation *va) {
+    stk.clear();
+    stk.push_back(frame { root, 1 });
+    while (stk.size()) {
+        auto &[ cur, idx ] = stk.back();
+        const auto c = va->reason(cur);
+        if (idx == c->size()) {
+            cache[index(cur)] |= visited_bit | ok_bit;
+            touched.push_back(cur);
+            stk.pop_back();
             continue;
         }
-        bool ok = true;
-        for (auto f : redges[std::abs(e)]) {
-            traverse(f);
-            if (cache[f] & ok_bit) continue;
-            ok = false;
-            break;
+        const auto f = c->get(idx++);
+        const auto v = var(f);
+        const int x = index(v);
+        if (mark[x] || va->decided(f) == 0 || (cache[x] & ok_bit)) continue;
+        if ((cache[x] & visited_bit) || va->reason(v) == nullptr) {
+            for (const auto &fr : stk) {
+                cache[index(fr.v)] |= visited_bit;
+                touched.push_back(fr.v);
+            }
+            return false;
         }
-        if (!ok) r.push_back(e);
-    }
-    for (auto e : buf) mark[std::abs(e)] = 1;
-}
-
-void ImplicationGraph::traverse(const int cur) {
-    if (cache[cur] & visited_bit) return;
-    
-    cache[cur] |= visited_bit;
-    
-    if (mark[cur]) {
-        cache[cur] |= ok_bit;
-        return;
-    }
-    
-    if (decision_v[cur]) return;
-    
-    for (auto e : redges[cur]) {
-        if (!(cache[e] & visited_bit)) traverse(e);
-        if (!(cache[e] & ok_bit)) return;
+        stk.push_back(frame { v, 1 });
     }
-    cache[cur] |= ok_bit;
+    return true;
 }
@@ -2,24 +2,29 @@
 
 #include "../cnf.hpp"
 
+// Views the reasons stored in Valuation as the implication graph.
 struct ImplicationGraph {
     ImplicationGraph() = delete;
     ImplicationGraph(const int pnum);
 
-    void imply(const Clause *c, const int p);
-    void decision(const int p);
-    void reset_imply(const Clause *c, const int p);
-    void reset_decision(const int p);
-
+    // r[0] is the asserting literal and is always kept
     void local_minimize(raw_clause &r, const Valuation *va);
-    void recursive_minimize(raw_clause &r);
+    void recursive_minimize(raw_clause &r, const Valuation *va);
+    void grow(const int pnum);
 
 private:
     constexpr static int visited_bit = 1 << 0;
     constexpr static int ok_bit = 1 << 1;
 
-    std::vector<std::vector<int>> redges;
-    std::vector<int> mark, cache, decision_v;
+    struct frame {
+        Var v;
+        int idx;
+    };
+
+    std::vector<int> mark, cache;
+    std::vector<Var> touched;
+    std::vector<frame> stk;
 
-    void traverse(const int cur);
+    bool traverse(const Var root, const Valuation *va);
+    void compact(raw_clause &r);
 };
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cdcl {
+
+// The numeric parameters of the search; the branching heuristic has its own
+// branch_options. See config.hpp for their names in configuration files.
+struct params {
+    int restart_window;              // glucose restarts: learnt clauses in the recent averages
+    double restart_margin;           // glucose restarts: K, restart once recent LBD * K > average
+    std::uint64_t luby_unit;         // luby restarts: conflicts of the unit
+    std::uint64_t reduce_base;       // reduce once learnts > reduce_base + reduce_step * reductions
+    std::uint64_t reduce_step;
+    std::uint64_t keep_lbd;          // learnt clauses of pseudo LBD at most this survive reductions
+    std::uint64_t rephase_interval;  // the gap between rephases grows by this every time
+    std::uint64_t walk_flips;        // per variable, of a walk rephase
+    std::uint64_t chrono_conflicts;  // chronological backtracking starts after these conflicts
+};
+
+constexpr params default_params { 50, 0.8, 100, 20000, 500, 3, 1000, 100, 4000 };
+
+}
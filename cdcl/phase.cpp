@@ -0,0 +1,123 @@
+#include "phase.hpp"
+#include <algorithm>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+namespace {
+
+constexpr char cycle[] = "BWBOBWBIBWBR";
+
+}
+
+Phases::Phases(const int pnum)
+    : pnum(pnum),
+      target(pnum + 1, PValue::BOTTOM),
+      best(pnum + 1, PValue::BOTTOM),
+      target_size(0),
+      best_size(0),
+      interval(1000),
+      count(0),
+      next(interval),
+      rng(42)
+{
+}
+
+void Phases::grow(const int pnum_) {
+    pnum = pnum_;
+    target.resize(pnum + 1, PValue::BOTTOM);
+    best.resize(pnum + 1, PValue::BOTTOM);
+}
+
+void Phases::save(Writer &w) const {
+    w.put(target);
+    w.put(best);
+    w.put(target_size);
+    w.put(best_size);
+    w.put(count);
+    w.put(next);
+}
+
+bool Phases::load(Reader &r) {
+    return r.get(target, pnum + 1) && r.get(best, pnum + 1)
+        && r.get(target_size) && r.get(best_size) && r.get(count) && r.get(next)
+        && 0 <= target_size && target_size <= pnum && 0 <= best_size && best_size <= pnum
+        && std::all_of(ALL(target), is_pvalue) && std::all_of(ALL(best), is_pvalue);
+}
+
+int Phases::best_trail() const {
+    return best_size;
+}
+
+void Phases::update(const std::vector<Literal> &trail, const int n) {
+    if (n <= target_size && n <= best_size) return;
+    auto copy = [&](std::vector<PValue> &dst) {
+        for (int i = 0; i < n; i++) {
+            const auto p = trail[i];
+            dst[index(var(p))] = (is_neg(p) ? PValue::FALSE : PValue::TRUE);
+        }
+    };
+    if (target_size < n) {
+        target_size = n;
+        copy(target);
+    }
+    if (best_size < n) {
+        best_size = n;
+        copy(best);
+    }
+}
+
+PValue Phases::pick(const Var v, const Valuation *va) const {
+    const auto t = target[index(v)];
+    return t == PValue::BOTTOM ? va->get_cache(v) : t;
+}
+
+void Phases::prefer(const Literal p, Valuation *va) {
+    va->set_cache(var(p), is_neg(p) ? PValue::FALSE : PValue::TRUE);
+    target[index(var(p))] = PValue::BOTTOM;
+}
+
+void Phases::set_interval(const std::uint64_t interval_) {
+    interval = interval_;
+    next = interval;
+}
+
+bool Phases::should_rephase(const std::uint64_t conflicts) const {
+    return next <= conflicts;
+}
+
+char Phases::rephase(Valuation *va, const std::uint64_t conflicts) {
+    const char kind = (count < 2 ? "OI"[count] : cycle[(count - 2) % (sizeof(cycle) - 1)]);
+    count++;
+    // arithmetic schedule: the gaps grow by interval every time
+    next = conflicts + interval * (count + 1);
+
+    std::bernoulli_distribution coin;
+    for (int i = 1; i <= pnum; i++) {
+        const auto v = Var(i);
+        switch (kind) {
+            case 'O':
+                va->set_cache(v, PValue::FALSE);
+                break;
+            case 'I':
+                va->set_cache(v, PValue::TRUE);
+                break;
+            case 'B':
+                if (best[i] != PValue::BOTTOM) va->set_cache(v, best[i]);
+                break;
+            case 'R':
+                va->set_cache(v, coin(rng) ? PValue::TRUE : PValue::FALSE);
+                break;
+        }
+    }
+    if (kind == 'B') {
+        best_size = 0;
+        std::fill(ALL(best), PValue::BOTTOM);
+    }
+    reset_target();
+    return kind;
+}
+
+void Phases::reset_target() {
+    target_size = 0;
+    std::fill(ALL(target), PValue::BOTTOM);
+}
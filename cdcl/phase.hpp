@@ -0,0 +1,40 @@
+#pragma once
+
+#include <random>
+#include "../cnf.hpp"
+#include "serial.hpp"
+
+// Target and best phases (Biere and Fleury, 2020).
+// target : assignment of the longest conflict-free trail since the last rephase
+// best   : same, but only forgotten after it has been used by a rephase
+// A decision takes the target phase of a variable if it has one, else its saved phase.
+// Rephasing overwrites every saved phase in the cycle O I (B W B O B W B I B W B R)*;
+// the walk (W) is left to the caller, which runs local search from the saved phases.
+struct Phases {
+    Phases() = delete;
+    Phases(const int pnum);
+
+    // trail[0, n) is free of conflicts
+    void update(const std::vector<Literal> &trail, const int n);
+    PValue pick(const Var v, const Valuation *va) const;
+    void prefer(const Literal p, Valuation *va);  // p becomes the saved phase and the target one is dropped
+    void grow(const int pnum_);
+    int best_trail() const;  // length of the best trail since the last best rephase
+    void save(Writer &w) const;  // everything but the random generator
+    bool load(Reader &r);
+
+    // the gap between rephases grows by interval every time; only before the first one
+    void set_interval(const std::uint64_t interval_);
+    bool should_rephase(const std::uint64_t conflicts) const;
+    // returns the kind of rephase: 'O'riginal, 'I'nverted, 'B'est, 'W'alk or 'R'andom
+    char rephase(Valuation *va, const std::uint64_t conflicts);
+
+private:
+    int pnum;
+    std::vector<PValue> target, best;
+    int target_size, best_size;
+    std::uint64_t interval, count, next;
+    std::mt19937 rng;
+
+    void reset_target();
+};
@@ -0,0 +1,202 @@
+#include "policy.hpp"
+
+namespace cdcl {
+
+/* ========== bounded_queue ========== */
+
+bounded_queue::bounded_queue(const int bound_)
+    : bound_(bound_),
+      head(0),
+      len(0),
+      sum_(0),
+      g_sum_(0),
+      g_size_(0),
+      que(bound_)
+{
+}
+
+void bounded_queue::push(const std::uint64_t v) {
+    if (len == bound_) pop();
+    que[(head + len) % bound_] = v;
+    len++;
+    sum_ += v;
+    g_sum_ += v;
+    g_size_++;
+}
+
+void bounded_queue::pop() {
+    sum_ -= que[head];
+    head = (head + 1) % bound_;
+    len--;
+}
+
+void bounded_queue::clear() {
+    head = len = 0;
+    sum_ = 0;
+}
+
+bool bounded_queue::is_full() const noexcept {
+    return len == bound_;
+}
+
+std::uint64_t bounded_queue::sum() const noexcept {
+    return sum_;
+}
+
+std::uint64_t bounded_queue::bound() const noexcept {
+    return bound_;
+}
+
+std::uint64_t bounded_queue::global_sum() const noexcept {
+    return g_sum_;
+}
+
+std::uint64_t bounded_queue::global_size() const noexcept {
+    return g_size_;
+}
+
+void bounded_queue::save(Writer &w) const {
+    w.put(head);
+    w.put(len);
+    w.put(sum_);
+    w.put(g_sum_);
+    w.put(g_size_);
+    w.put(que);
+}
+
+bool bounded_queue::load(Reader &r) {
+    if (!r.get(head) || !r.get(len) || !r.get(sum_) || !r.get(g_sum_) || !r.get(g_size_) || !r.get(que, bound_)) return false;
+    // push() and pop() index que with head and len
+    return 0 <= head && head < bound_ && 0 <= len && len <= bound_;
+}
+
+
+/* ========== GlucoseRestart ========== */
+
+GlucoseRestart::GlucoseRestart(const params &p)
+    : K(p.restart_margin),
+      lbd_que(p.restart_window),
+      conflict_que(p.restart_window)
+{
+}
+
+void GlucoseRestart::conflict(const std::uint64_t lbd, const int cl) {
+    conflict_que.push(cl);
+    lbd_que.push(lbd);
+}
+
+bool GlucoseRestart::should_restart() const {
+    if (!lbd_que.is_full()) return false;
+
+    {
+        auto v1 = double(lbd_que.sum());
+        v1 /= lbd_que.bound();
+        v1 *= K;
+        auto v2 = double(lbd_que.global_sum()) / conflict_que.global_size();
+        if (v1 > v2) return true;
+    }
+
+    {
+        auto v1 = double(conflict_que.sum());
+        v1 /= conflict_que.bound();
+        auto v2 = double(conflict_que.global_sum()) / conflict_que.global_size();
+        return v1 > v2;
+    }
+}
+
+void GlucoseRestart::restarted() {
+    lbd_que.clear();
+    conflict_que.clear();
+}
+
+void GlucoseRestart::save(Writer &w) const {
+    lbd_que.save(w);
+    conflict_que.save(w);
+}
+
+bool GlucoseRestart::load(Reader &r) {
+    return lbd_que.load(r) && conflict_que.load(r);
+}
+
+
+/* ========== LubyRestart ========== */
+
+namespace {
+
+// 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ... for i = 0, 1, 2, ...
+std::uint64_t luby(std::uint64_t i) {
+    std::uint64_t size = 1;
+    int seq = 0;
+    while (size < i + 1) {
+        seq++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) >> 1;
+        seq--;
+        i %= size;
+    }
+    return std::uint64_t(1) << seq;
+}
+
+}
+
+LubyRestart::LubyRestart(const params &p)
+    : unit(p.luby_unit),
+      count(0),
+      limit(unit * luby(0)),
+      i(0)
+{
+}
+
+void LubyRestart::conflict(const std::uint64_t, const int) {
+    count++;
+}
+
+bool LubyRestart::should_restart() const {
+    return limit <= count;
+}
+
+void LubyRestart::restarted() {
+    count = 0;
+    limit = unit * luby(++i);
+}
+
+void LubyRestart::save(Writer &w) const {
+    w.put(count);
+    w.put(i);
+}
+
+bool LubyRestart::load(Reader &r) {
+    if (!r.get(count) || !r.get(i)) return false;
+    limit = unit * luby(i);
+    return true;
+}
+
+
+/* ========== DratProof ========== */
+
+DratProof::DratProof()
+    : out(nullptr),
+      concluded(false)
+{
+}
+
+void DratProof::set_output(std::ostream *os) {
+    out = os;
+}
+
+void DratProof::add(const raw_clause &r) {
+    if (out == nullptr) return;
+    for (auto p : r) *out << to_dimacs(p) << ' ';
+    *out << "0\n";
+}
+
+void DratProof::conclude() {
+    if (out == nullptr || concluded) return;
+    concluded = true;
+    *out << "0\n";
+    out->flush();
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include "../cnf.hpp"
+#include "branch.hpp"
+#include "graph.hpp"
+#include "params.hpp"
+#include "serial.hpp"
+
+namespace cdcl {
+
+// Policies are the choices which the search loop makes after every conflict. A solver
+// is instantiated over one of each (see cdcl::policy), so that its loop is compiled
+// with them fixed instead of testing a setting every time.
+
+struct bounded_queue {
+    bounded_queue(const int bound_);
+
+    void push(const std::uint64_t v);
+    void pop();
+    void clear();
+    bool is_full() const noexcept;
+    std::uint64_t bound() const noexcept;
+    std::uint64_t sum() const noexcept;
+    std::uint64_t global_sum() const noexcept;
+    std::uint64_t global_size() const noexcept;
+    void save(Writer &w) const;
+    bool load(Reader &r);
+
+private:
+    int bound_;
+    int head, len;
+    std::uint64_t sum_, g_sum_, g_size_;
+    std::vector<std::uint64_t> que;
+};
+
+
+/* ========== restart ========== */
+
+// Every restart policy is built from the params of the solver, told of each learnt clause
+// by conflict(), asked by should_restart() right after it, and told of the restart by restarted().
+
+// Restarts once the LBDs of the last restart_window learnt clauses are worse than the average
+// of all of them, or their conflicts happen at higher levels (Audemard and Simon, 2012).
+struct GlucoseRestart {
+    constexpr static char tag = 'G';
+
+    GlucoseRestart() = delete;
+    GlucoseRestart(const params &p);
+
+    void conflict(const std::uint64_t lbd, const int cl);
+    bool should_restart() const;
+    void restarted();
+    void save(Writer &w) const;
+    bool load(Reader &r);
+
+private:
+    double K;
+    bounded_queue lbd_que, conflict_que;
+};
+
+// Restarts after luby_unit * luby(i) conflicts for the i-th time (Luby et al., 1993).
+struct LubyRestart {
+    constexpr static char tag = 'L';
+
+    LubyRestart() = delete;
+    LubyRestart(const params &p);
+
+    void conflict(const std::uint64_t lbd, const int cl);
+    bool should_restart() const;
+    void restarted();
+    void save(Writer &w) const;
+    bool load(Reader &r);
+
+private:
+    std::uint64_t unit;
+    std::uint64_t count, limit;
+    std::uint64_t i;
+};
+
+
+/* ========== minimization ========== */
+
+// drops the literals of a learnt clause whose reason holds only other literals of it
+struct LocalMinimize {
+    static void minimize(ImplicationGraph &g, raw_clause &r, const Valuation *va) {
+        g.local_minimize(r, va);
+    }
+};
+
+// also follows the reasons back through literals outside of the clause (Sörensson and Biere, 2009)
+struct RecursiveMinimize {
+    static void minimize(ImplicationGraph &g, raw_clause &r, const Valuation *va) {
+        g.recursive_minimize(r, va);
+    }
+};
+
+
+/* ========== clause storage ========== */
+
+// Asked at every restart whether the learnt clauses should be reduced, which keeps the
+// locked ones and those of pseudo LBD at most keep_lbd. limit() is the number of learnt
+// clauses the next reduction waits for, whose storage the reduction reserves.
+
+// every reduce_base + reduce_step * reductions learnt clauses, as Glucose does
+struct GlucoseReduce {
+    static bool should_reduce(const std::uint64_t learnts, const std::uint64_t reductions, const params &p) {
+        return limit(reductions, p) < learnts;
+    }
+    static std::uint64_t limit(const std::uint64_t reductions, const params &p) {
+        return p.reduce_base + p.reduce_step * reductions;
+    }
+};
+
+// never, for short searches which want every clause they have learnt
+struct KeepLearnts {
+    static bool should_reduce(const std::uint64_t, const std::uint64_t, const params&) {
+        return false;
+    }
+    static std::uint64_t limit(const std::uint64_t, const params&) {
+        return 0;
+    }
+};
+
+
+/* ========== proof ========== */
+
+// Proof policies see every learnt clause before it is added, and the empty clause once
+// the clauses are found unsatisfiable.
+
+struct NoProof {
+    void set_output(std::ostream*) { }
+    void add(const raw_clause&) { }
+    void conclude() { }
+};
+
+// DRAT proof in text, without deletions: the learnt clauses follow from the original
+// clauses by unit propagation as long as the formula has no cardinality or XOR constraint,
+// no clause is added after the first search and no checkpoint is loaded.
+struct DratProof {
+    DratProof();
+
+    void set_output(std::ostream *os);  // nothing is written without one
+    void add(const raw_clause &r);
+    void conclude();
+
+private:
+    std::ostream *out;
+    bool concluded;
+};
+
+
+/* ========== instantiations ========== */
+
+template <typename Restart, typename Minimize, typename Storage, typename Proof,
+          typename Branch = VSIDSBranch, bool Check = true>
+struct policy {
+    using restart = Restart;
+    using minimize = Minimize;
+    using storage = Storage;
+    using proof = Proof;
+    using branch = Branch;  // see branch.hpp
+    // checks every model against the clauses and constraints before returning SAT
+    constexpr static bool check = Check;
+};
+
+// The instantiations built into libcdcl
+using default_policy = policy<GlucoseRestart, LocalMinimize, GlucoseReduce, NoProof>;
+using luby_policy = policy<LubyRestart, LocalMinimize, GlucoseReduce, NoProof>;
+using recursive_policy = policy<GlucoseRestart, RecursiveMinimize, GlucoseReduce, NoProof>;
+using keep_policy = policy<GlucoseRestart, LocalMinimize, KeepLearnts, NoProof>;
+using drat_policy = policy<GlucoseRestart, LocalMinimize, GlucoseReduce, DratProof>;
+
+// Policy with the branching heuristic Branch in place of its own; libcdcl builds each of
+// the instantiations above with each of VSIDSBranch, LRBBranch, CHBBranch and SwitchBranch.
+template <typename Policy, typename Branch>
+using with_branch = policy<typename Policy::restart, typename Policy::minimize, typename Policy::storage,
+                           typename Policy::proof, Branch, Policy::check>;
+
+}
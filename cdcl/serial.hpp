@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+// Fields of checkpoints (see CDCL::save): trivially copyable values in host byte
+// order, and vectors as their length followed by their elements.
+struct Writer {
+    std::ostream &out;
+
+    template <typename T>
+    void put(const T &x) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.write(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+
+    template <typename T>
+    void put(const std::vector<T> &v) {
+        put(std::uint64_t(v.size()));
+        out.write(reinterpret_cast<const char*>(v.data()), sizeof(T) * v.size());
+    }
+};
+
+// every get() is false once the input has ended early or a length differs from the expected one
+struct Reader {
+    std::istream &in;
+
+    template <typename T>
+    bool get(T &x) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return bool(in.read(reinterpret_cast<char*>(&x), sizeof(T)));
+    }
+
+    template <typename T>
+    bool get(std::vector<T> &v, const std::size_t expected) {
+        std::uint64_t n;
+        if (!get(n) || n != expected) return false;
+        v.resize(n);
+        return bool(in.read(reinterpret_cast<char*>(v.data()), sizeof(T) * n));
+    }
+
+    // of any length up to limit
+    template <typename T>
+    bool get_at_most(std::vector<T> &v, const std::size_t limit) {
+        std::uint64_t n;
+        if (!get(n) || limit < n) return false;
+        v.resize(n);
+        return bool(in.read(reinterpret_cast<char*>(v.data()), sizeof(T) * n));
+    }
+};
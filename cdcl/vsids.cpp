@@ -1,4 +1,5 @@
 #include "vsids.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -16,12 +17,52 @@ SegmentTree::SegmentTree(const int pnum)
       data(n_pow2 * 2 - 1, invalid)
 {
     for (int i = 1; i <= pnum; i++) data[offset + i] = element { 0, i, true };
+    build();
+}
+
+void SegmentTree::build() {
     for (int i = offset - 1; 0 <= i; i--) {
         auto [ c1, c2 ] = child(i);
         data[i] = comp(data[c1], data[c2]);
     }
 }
 
+// the capacity doubles when it runs out, so adding variables one by one stays linear
+void SegmentTree::grow(const int pnum) {
+    if (pnum + 1 <= n) return;
+    if (n_pow2 < pnum + 1) {
+        const int m = std::max(ceil_pow2(pnum + 1), 2 * n_pow2);
+        std::vector<element> next(m * 2 - 1, invalid);
+        std::copy_n(std::begin(data) + offset, n, std::begin(next) + (m - 1));
+        data.swap(next);
+        n_pow2 = m;
+        offset = m - 1;
+        for (int i = n; i <= pnum; i++) data[offset + i] = element { 0, i, true };
+        n = pnum + 1;
+        build();
+        return;
+    }
+    for (int i = n; i <= pnum; i++) {
+        data[offset + i] = element { 0, i, true };
+        update(i);
+    }
+    n = pnum + 1;
+}
+
+void SegmentTree::save(Writer &w) const {
+    std::vector<double> score(n, 0);
+    for (int i = 1; i < n; i++) score[i] = data[offset + i].score;
+    w.put(score);
+}
+
+bool SegmentTree::load(Reader &r) {
+    std::vector<double> score;
+    if (!r.get(score, n)) return false;
+    for (int i = 1; i < n; i++) data[offset + i].score = score[i];
+    build();
+    return true;
+}
+
 SegmentTree::element SegmentTree::comp(const element &e1, const element &e2) {
     if (!e1.active && !e2.active) return invalid;
     if (e1.active && !e2.active) return e1;
@@ -36,23 +77,35 @@ SegmentTree::element SegmentTree::get() const {
 void SegmentTree::div(const int d) {
     for (auto &e : data) {
         if (e.score < 0) continue;
-        e.score /= d;
+        e.score = std::floor(e.score / d);
     }
 }
 
-void SegmentTree::inc(const int i) {
-    data[offset + i].score += 1;
-    update(i);
+void SegmentTree::inc(const Var v) {
+    data[offset + index(v)].score += 1;
+    update(index(v));
+}
+
+// the path to the root is only stale for an active variable
+void SegmentTree::set(const Var v, const double score) {
+    auto &e = data[offset + index(v)];
+    e.score = score;
+    if (e.active) update(index(v));
+}
+
+void SegmentTree::remove(const Var v) {
+    data[offset + index(v)].active = false;
+    update(index(v));
 }
 
-void SegmentTree::remove(const int i) {
-    data[offset + i].active = false;
-    update(i);
+void SegmentTree::restore(const Var v) {
+    data[offset + index(v)].active = true;
+    update(index(v));
 }
 
-void SegmentTree::restore(const int i) {
-    data[offset + i].active = true;
-    update(i);
+void SegmentTree::activate(const Valuation *va) {
+    for (int i = 1; i < n; i++) data[offset + i].active = (va->get_value(Var(i)) == PValue::BOTTOM);
+    build();
 }
 
 void SegmentTree::update(int i) {
@@ -79,8 +132,8 @@ VSIDS::VSIDS(const int pnum_,
 {
 }
 
-void VSIDS::vsi(Clause *c) {
-    for (int i = 0; i < c->size(); i++) seg.inc(std::abs(c->get(i)));
+void VSIDS::vsi(const raw_clause &c) {
+    for (auto p : c) seg.inc(var(p));
     count_add++;
     if (count_add == span) {
         count_add = 0;
@@ -88,21 +141,39 @@ void VSIDS::vsi(Clause *c) {
     }
 }
 
-void VSIDS::assign(const int p) {
-    seg.remove(std::abs(p));
+void VSIDS::assign(const Var v) {
+    seg.remove(v);
+}
+
+void VSIDS::rollback(const Var v) {
+    seg.restore(v);
+}
+
+void VSIDS::grow(const int pnum_) {
+    pnum = pnum_;
+    seg.grow(pnum);
+}
+
+void VSIDS::activate(const Valuation *va) {
+    seg.activate(va);
+}
+
+void VSIDS::save(Writer &w) const {
+    w.put(count_add);
+    seg.save(w);
 }
 
-void VSIDS::rollback(const int p) {
-    seg.restore(std::abs(p));
+bool VSIDS::load(Reader &r) {
+    return r.get(count_add) && seg.load(r);
 }
 
 void VSIDS::ds() {
     seg.div(div);
 }
 
-std::optional<int> VSIDS::pickup() {
+std::optional<Var> VSIDS::pickup() {
     auto e = seg.get();
     //std::cout << e.score << ", " << e.idx << std::endl;
     if (!e.active) return std::nullopt;
-    return e.idx;
+    return Var(e.idx);
 }
@@ -1,21 +1,29 @@
 #pragma once
 
 #include "../cnf.hpp"
+#include "serial.hpp"
 
+// max-score variable among the active (unassigned) ones
 struct SegmentTree {
     struct element {
-        int score, idx;
+        double score;
+        int idx;
         bool active;
     };
 
     SegmentTree(const int pnum_);
 
-    element access(const int i) const;
+    element access(const Var v) const;
     element get() const;
     void div(const int d);
-    void inc(const int i);
-    void remove(const int i);
-    void restore(const int i);
+    void inc(const Var v);
+    void set(const Var v, const double score);
+    void remove(const Var v);
+    void restore(const Var v);
+    void activate(const Valuation *va);  // exactly the unassigned variables become active
+    void grow(const int pnum);           // new variables are active with score 0
+    void save(Writer &w) const;          // the scores
+    bool load(Reader &r);
 
 private:
     int n;
@@ -24,6 +32,7 @@ private:
     element invalid;
     std::vector<element> data;
 
+    void build();
     void update(int i);
     element comp(const element &e1, const element &e2);
     std::pair<int, int> child(const int i) const;
@@ -35,10 +44,14 @@ struct VSIDS {
           const int div_, 
           const int span_);
 
-    void vsi(Clause *c);
-    std::optional<int> pickup();
-    void assign(const int p);
-    void rollback(const int p);
+    void vsi(const raw_clause &c);
+    std::optional<Var> pickup();
+    void assign(const Var v);
+    void rollback(const Var v);
+    void activate(const Valuation *va);
+    void grow(const int pnum_);
+    void save(Writer &w) const;
+    bool load(Reader &r);
 
 private:
     int pnum;
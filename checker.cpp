@@ -0,0 +1,151 @@
+#include "checker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <immintrin.h>
+
+namespace {
+
+// literals evaluated per batch, and the least number of literals worth a thread
+constexpr int block_size = 4096;
+constexpr std::size_t lits_per_thread = 1 << 18;
+
+void gather_scalar(const std::uint8_t *table, const std::uint32_t *idx, const int n, std::uint8_t *out) {
+    for (int i = 0; i < n; i++) out[i] = table[idx[i]];
+}
+
+__attribute__((target("avx2")))
+void gather_avx2(const std::uint8_t *table, const std::uint32_t *idx, const int n, std::uint8_t *out) {
+    const auto low = _mm256_set1_epi32(0xff);
+    const auto shuffle = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const auto vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + i));
+        auto g = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), vi, 1);
+        g = _mm256_shuffle_epi8(_mm256_and_si256(g, low), shuffle);
+        const auto lo = std::uint32_t(_mm256_extract_epi32(g, 0));
+        const auto hi = std::uint32_t(_mm256_extract_epi32(g, 4));
+        const std::uint64_t bytes = std::uint64_t(lo) | (std::uint64_t(hi) << 32);
+        __builtin_memcpy(out + i, &bytes, 8);
+    }
+    gather_scalar(table, idx + i, n - i, out + i);
+}
+
+using gather_fn = void (*)(const std::uint8_t*, const std::uint32_t*, const int, std::uint8_t*);
+
+gather_fn select_gather() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? gather_avx2 : gather_scalar;
+}
+
+const gather_fn gather = select_gather();
+
+}
+
+ModelChecker::ModelChecker(const std::vector<raw_clause> &clauses)
+    : pnum(0)
+{
+    offset.reserve(clauses.size() + 1);
+    offset.push_back(0);
+    for (const auto &r : clauses) push(r);
+    table.assign(2 * (pnum + 1) + 4, 0);
+}
+
+ModelChecker::ModelChecker(CNF *cnf, const int num)
+    : pnum(cnf->get_pnum())
+{
+    offset.reserve(num + 1);
+    offset.push_back(0);
+    for (int i = 0; i < num; i++) push(cnf->get(i)->raw());
+    table.assign(2 * (pnum + 1) + 4, 0);
+}
+
+void ModelChecker::push(const raw_clause &r) {
+    for (auto p : r) {
+        lits.push_back(index(p));
+        pnum = std::max(pnum, index(var(p)));
+    }
+    offset.push_back(lits.size());
+}
+
+void ModelChecker::load(const Valuation *va) {
+    std::fill(std::begin(table), std::end(table), 0);
+    const int n = std::min(pnum, va->get_pnum());
+    for (int i = 1; i <= n; i++) {
+        for (auto p : { make_lit(Var(i), false), make_lit(Var(i), true) }) {
+            table[index(p)] = (va->get_value(p) == PValue::TRUE);
+        }
+    }
+}
+
+bool ModelChecker::assign(const Literal p) {
+    if (pnum < index(var(p))) return true;
+    if (table[index(~p)]) return false;
+    table[index(p)] = 1;
+    return true;
+}
+
+int ModelChecker::size() const {
+    return int(offset.size()) - 1;
+}
+
+std::optional<int> ModelChecker::scan(const int lo, const int hi) const {
+    std::uint8_t truth[block_size];
+    int i = lo;
+    while (i < hi) {
+        // clauses [i, j) fit in one batch; a longer clause forms a batch of its own
+        int j = i + 1;
+        while (j < hi && offset[j + 1] - offset[i] <= std::uint32_t(block_size)) j++;
+        const auto fst = offset[i];
+        for (auto base = fst; base < offset[j]; base += block_size) {
+            const int n = std::min<std::uint32_t>(block_size, offset[j] - base);
+            gather(table.data(), lits.data() + base, n, truth);
+            if (j == i + 1) {
+                // a single clause, possibly spanning several batches
+                if (std::any_of(truth, truth + n, [](std::uint8_t t) { return t; })) goto next;
+                continue;
+            }
+            for (int k = i; k < j; k++) {
+                const auto b = truth + (offset[k] - fst), e = truth + (offset[k + 1] - fst);
+                if (std::none_of(b, e, [](std::uint8_t t) { return t; })) return k;
+            }
+            goto next;
+        }
+        return i;
+    next:
+        i = j;
+    }
+    return std::nullopt;
+}
+
+std::optional<int> ModelChecker::find_falsified(int threads) const {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<std::size_t>(threads, lits.size() / lits_per_thread + 1);
+    if (threads <= 1) return scan(0, size());
+
+    // split by literals, not clauses, so that every thread gets the same work
+    std::vector<int> bound(threads + 1, size());
+    bound[0] = 0;
+    for (int t = 1; t < threads; t++) {
+        const std::uint32_t target = lits.size() * t / threads;
+        bound[t] = std::lower_bound(std::begin(offset), std::end(offset), target) - std::begin(offset);
+        bound[t] = std::min(std::max(bound[t], bound[t - 1]), size());
+    }
+
+    std::atomic<int> res(size());
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            auto r = scan(bound[t], bound[t + 1]);
+            if (!r.has_value()) return;
+            int cur = res.load();
+            while (*r < cur && !res.compare_exchange_weak(cur, *r));
+        });
+    }
+    for (auto &w : workers) w.join();
+    if (res.load() == size()) return std::nullopt;
+    return res.load();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include "cnf.hpp"
+
+// Checks a full assignment against a formula.
+// The clauses are flattened into one literal array and every literal is evaluated
+// by a lookup in a per-literal table, eight at a time with AVX2 gathers when available.
+struct ModelChecker {
+    ModelChecker() = delete;
+    ModelChecker(const std::vector<raw_clause> &clauses);
+    ModelChecker(CNF *cnf, const int num);  // the first num clauses of cnf
+
+    void load(const Valuation *va);
+    bool assign(const Literal p);  // false if ~p is already assigned
+
+    // index of a clause with no true literal; threads = 0 picks the hardware concurrency
+    std::optional<int> find_falsified(int threads = 0) const;
+    int size() const;
+
+private:
+    int pnum;
+    std::vector<std::uint32_t> lits;
+    std::vector<std::uint32_t> offset;  // clause i is lits[offset[i]..offset[i + 1])
+    std::vector<std::uint8_t> table;    // 1 if the literal is true; padded for 32-bit gathers
+
+    void push(const raw_clause &r);
+    std::optional<int> scan(const int lo, const int hi) const;
+};
@@ -3,11 +3,12 @@
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <numeric>
 
 #define ALL(V) std::begin(V), std::end(V)
 
-bool match(const int p, const PValue v) {
-    return 0 < p * static_cast<int>(v);
+PValue negate(const PValue v) {
+    return static_cast<PValue>(-static_cast<int>(v));
 }
 
 
@@ -15,139 +16,170 @@ bool match(const int p, const PValue v) {
 
 Valuation::Valuation(const int size_)
     : size(size_),
-      sigma(size + 1, PValue::BOTTOM),
-      cache(size + 1, PValue::FALSE),
-      dl_v(size + 1, -1),
-      implied(size + 1, 0)
+      sigma(2 * (size + 1), PValue::BOTTOM),
+      data(size + 1, var_data { nullptr, -1, PValue::FALSE })
 {
 }
 
-PValue Valuation::get_value(const int p) const {
-    return sigma[std::abs(p)];
+PValue Valuation::get_value(const Var v) const {
+    return sigma[index(make_lit(v, false))];
 }
 
-int Valuation::decided(const int p) const {
-    return dl_v[std::abs(p)];
+PValue Valuation::get_value(const Literal p) const {
+    return sigma[index(p)];
 }
 
-void Valuation::assign(const int p, const PValue v, const int dl) {
-    const int idx = std::abs(p);
-    sigma[idx] = v;
-    dl_v[idx] = dl;
+int Valuation::decided(const Var v) const {
+    return data[index(v)].dl;
 }
 
-void Valuation::imply(const int p, const int dl) {
-    assign(p, 0 < p ? PValue::TRUE : PValue::FALSE, dl);
-    implied[std::abs(p)] = true;
+int Valuation::decided(const Literal p) const {
+    return data[index(var(p))].dl;
+}
+
+void Valuation::assign(const Var x, const PValue v, const int dl) {
+    sigma[index(make_lit(x, false))] = v;
+    sigma[index(make_lit(x, true))] = negate(v);
+    data[index(x)].dl = dl;
+}
+
+void Valuation::imply(const Literal p, const int dl, Clause *reason) {
+    sigma[index(p)] = PValue::TRUE;
+    sigma[index(~p)] = PValue::FALSE;
+    auto &d = data[index(var(p))];
+    d.dl = dl;
+    d.reason = reason;
 }
 
 int Valuation::get_pnum() const {
     return size;
 }
 
-void Valuation::reset(const int p) {
-    const int idx = std::abs(p);
-    cache[idx] = sigma[idx];
-    sigma[idx] = PValue::BOTTOM;
-    dl_v[idx] = -1;
-    implied[idx] = 0;
+void Valuation::grow(const int n) {
+    if (n <= size) return;
+    size = n;
+    sigma.resize(2 * (size + 1), PValue::BOTTOM);
+    data.resize(size + 1, var_data { nullptr, -1, PValue::FALSE });
 }
 
-PValue Valuation::get_cache(const int p) const {
-    return cache[std::abs(p)];
+void Valuation::reset(const Var v) {
+    const auto p = make_lit(v, false);
+    auto &d = data[index(v)];
+    d.cache = sigma[index(p)];
+    d.dl = -1;
+    d.reason = nullptr;
+    sigma[index(p)] = sigma[index(~p)] = PValue::BOTTOM;
 }
 
-bool Valuation::was_implied(const int p) const {
-    return implied[std::abs(p)];
+PValue Valuation::get_cache(const Var v) const {
+    return data[index(v)].cache;
 }
 
+void Valuation::set_cache(const Var v, const PValue p) {
+    data[index(v)].cache = p;
+}
 
-/* ========== Clause ========== */
+bool Valuation::was_implied(const Var v) const {
+    return data[index(v)].reason != nullptr;
+}
 
-Clause::Clause(raw_clause clause_)
-    : clause(std::move(clause_)),
-      fst(0),
-      last(clause.size()),
-      state(ClauseState::Unknown),
-      cnf_idx(-1)
-{
-    std::sort(ALL(clause));
-    type = ClauseType::Original;
-    LBD = 0;
+Clause* Valuation::reason(const Var v) const {
+    return data[index(v)].reason;
 }
 
-Clause::Clause(raw_clause clause_, const Valuation *va) : Clause(std::move(clause_)) {
-    type = ClauseType::Learnt;
-    LBD = pseudo_LBD = calc_LBD(va);
+
+/* ========== LevelStamp ========== */
+
+LevelStamp::LevelStamp(const int pnum)
+    : round(0),
+      stamp(pnum + 1, 0)
+{
 }
 
-const raw_clause& Clause::raw() const {
-    return clause;
+void LevelStamp::grow(const int pnum) {
+    stamp.resize(pnum + 1, 0);
 }
 
-int Clause::get(const int idx) const {
-    return clause[idx];
+void LevelStamp::next() {
+    if (++round != 0) return;
+    std::fill(ALL(stamp), 0);
+    round = 1;
 }
 
-int Clause::size() const {
-    return clause.size();
+bool LevelStamp::mark(const int dl) {
+    if (stamp[dl] == round) return false;
+    stamp[dl] = round;
+    return true;
 }
 
-void Clause::update(const Valuation *va, const int dl) {
-    if (state == ClauseState::SAT || state == ClauseState::UNSAT) return;
 
-    while (fst < last) {
-        auto d = va->decided(clause[fst]);
-        if (d == -1 || dl < d) break;
-        const auto cur = va->get_value(clause[fst]);
-        assert(cur != PValue::BOTTOM);
-        fst++;
-        if (match(clause[fst - 1], cur)) {
-            state = ClauseState::SAT;
-            return;
-        }
-    }
-    while (fst < last) {
-        auto d = va->decided(clause[last - 1]);
-        if (d == -1 || dl < d) break;
-        const auto cur = va->get_value(clause[last - 1]);
-        assert(cur != PValue::BOTTOM);
-        last--;
-        if (match(clause[last], cur)) {
-            state = ClauseState::SAT;
-            return;
-        }
+/* ========== Clause ========== */
+
+namespace {
+
+int floor_log2(std::size_t n) {
+    int ret = 0;
+    while (1 < n) {
+        n >>= 1;
+        ret++;
     }
+    return ret;
+}
 
-    update_state(va);
+std::size_t ceil_pow2(const std::size_t n) {
+    std::size_t ret = 1;
+    while (ret < n) ret *= 2;
+    return ret;
 }
 
-void Clause::update_state(const Valuation *va) {
-    if (0 < fst && match(clause[fst - 1], va->get_value(clause[fst - 1]))) {
-        state = ClauseState::SAT;
-    } else if (last < size() && match(clause[last], va->get_value(clause[last]))) {
-        state = ClauseState::SAT;
-    } else if (fst + 1 == last) {
-        state = ClauseState::Unit;
-    } else if (fst == last) {
-        state = ClauseState::UNSAT;
-    } else {
-        state = ClauseState::Unknown;
-    }
 }
 
-void Clause::rollback(const int fst, const int last, ClauseState state) {
-    this->fst = fst;
-    this->last = last;
-    this->state = state;
+Clause::Clause(raw_clause clause_)
+    : type(ClauseType::Original),
+      cnf_idx(-1),
+      clause(std::move(clause_)),
+      LBD(0),
+      pseudo_LBD(0)
+{
+    std::sort(ALL(clause));
+    clause.erase(std::unique(ALL(clause)), std::end(clause));
 }
 
-std::pair<int, int> Clause::get_watch() const {
-    return std::make_pair(fst, last); 
+Clause::Clause(const raw_clause &clause_, const Valuation *va, LevelStamp &stamp)
+    : type(ClauseType::Learnt),
+      cnf_idx(-1)
+{
+    // learnt clauses are recycled, so round the capacity up to make reuse likely
+    clause.reserve(ceil_pow2(clause_.size()));
+    clause.assign(ALL(clause_));
+    LBD = pseudo_LBD = calc_LBD(va, stamp);
 }
 
-std::optional<int> Clause::unit() const {
-    return (state == ClauseState::Unit ? std::optional<int>(clause[fst]) : std::nullopt);
+const raw_clause& Clause::raw() const {
+    return clause;
+}
+
+raw_clause& Clause::raw() {
+    return clause;
+}
+
+Literal Clause::get(const int idx) const {
+    return clause[idx];
+}
+
+int Clause::size() const {
+    return clause.size();
+}
+
+std::size_t Clause::capacity() const {
+    return clause.capacity();
+}
+
+void Clause::relearn(const raw_clause &clause_, const Valuation *va, LevelStamp &stamp) {
+    assert(clause_.size() <= clause.capacity());
+    type = ClauseType::Learnt;
+    clause.assign(ALL(clause_));
+    LBD = pseudo_LBD = calc_LBD(va, stamp);
 }
 
 std::uint64_t Clause::get_LBD() const {
@@ -158,33 +190,45 @@ std::uint64_t Clause::get_pseudo_LBD() const {
     return pseudo_LBD;
 }
 
-// when unit propagatoin
-void Clause::recalc_LBD(const Valuation *va) {
-    const auto tmp = calc_LBD(va);
+// when used in conflict analysis
+void Clause::recalc_LBD(const Valuation *va, LevelStamp &stamp) {
+    const auto tmp = calc_LBD(va, stamp);
     if (tmp < LBD) {
         LBD = tmp;
         pseudo_LBD = LBD + 1;
     }
 }
 
-std::uint64_t Clause::calc_LBD(const Valuation *va) const {
-    std::vector<int> dv;
-    dv.reserve(clause.size());
+// when restored from a checkpoint
+void Clause::set_LBD(const std::uint64_t lbd, const std::uint64_t pseudo) {
+    LBD = lbd;
+    pseudo_LBD = pseudo;
+}
+
+std::uint64_t Clause::calc_LBD(const Valuation *va, LevelStamp &stamp) const {
+    stamp.next();
+    std::uint64_t ret = 0;
     for (auto e : clause) {
         auto d = va->decided(e);
         if (d == -1) continue;
-        dv.push_back(d);
+        if (stamp.mark(d)) ret++;
     }
-    std::sort(ALL(dv));
-    return std::distance(std::begin(dv), std::unique(ALL(dv)));
+    return ret;
 }
 
 /* ========== CNF ========== */
 
-CNF::CNF(std::vector<raw_clause> clauses_)
-    : clauses(clauses_.size()), pnum(0), original(int(clauses_.size()))
+CNF::CNF(std::vector<raw_clause> &&clauses_, std::vector<AtMost> &&cards_, std::vector<raw_clause> &&xors_)
+    : pnum(0),
+      original(int(clauses_.size())),
+      clauses(clauses_.size()),
+      cards(std::move(cards_)),
+      xors(std::move(xors_)),
+      learnt_sizes { }
 {
-    for (const auto &v : clauses_) for (auto e : v) pnum = std::max(pnum, std::abs(e));
+    for (const auto &v : clauses_) for (auto e : v) pnum = std::max(pnum, index(var(e)));
+    for (const auto &c : cards) for (auto e : c.lits) pnum = std::max(pnum, index(var(e)));
+    for (const auto &x : xors) for (auto e : x) pnum = std::max(pnum, index(var(e)));
     for (int i = 0; i < int(clauses.size()); i++) {
         clauses[i] = new Clause(std::move(clauses_[i]));
         clauses[i]->cnf_idx = i;
@@ -193,7 +237,7 @@ CNF::CNF(std::vector<raw_clause> clauses_)
 
 void CNF::free() {
     for (auto p : clauses) delete p;
-    for (auto p : removed) delete p;
+    for (const auto &v : removed) for (auto p : v) delete p;
 }
 
 void CNF::add(Clause *c) {
@@ -201,11 +245,31 @@ void CNF::add(Clause *c) {
     clauses.push_back(c);
 }
 
-void CNF::remove(Clause *c) {
-    auto ite = std::find(std::begin(clauses), std::end(clauses), c);
-    assert(ite == std::end(clauses));
-    clauses.erase(ite);
-    removed.push_back(c);
+// learnt clauses stay behind the original ones
+void CNF::add_original(Clause *c) {
+    add(c);
+    if (original + 1 < int(clauses.size())) {
+        std::swap(clauses[original], clauses.back());
+        clauses[original]->cnf_idx = original;
+        clauses.back()->cnf_idx = int(clauses.size()) - 1;
+    }
+    original++;
+}
+
+Clause* CNF::new_learnt(const raw_clause &r, const Valuation *va, LevelStamp &stamp) {
+    Clause *c = nullptr;
+    const int lb = floor_log2(ceil_pow2(r.size()));
+    learnt_sizes[lb]++;
+    for (int b = lb; b < int(removed.size()); b++) {
+        if (removed[b].empty()) continue;
+        c = removed[b].back();
+        removed[b].pop_back();
+        c->relearn(r, va, stamp);
+        break;
+    }
+    if (c == nullptr) c = new Clause(r, va, stamp);
+    add(c);
+    return c;
 }
 
 int CNF::size() const {
@@ -216,21 +280,75 @@ int CNF::get_pnum() const {
     return pnum;
 }
 
+void CNF::declare(const int n) {
+    pnum = std::max(pnum, n);
+}
+
 int CNF::get_learnt_clause_num() const {
     return int(clauses.size()) - original;
 }
 
+const std::vector<AtMost>& CNF::get_cards() const {
+    return cards;
+}
+
+const std::vector<raw_clause>& CNF::get_xors() const {
+    return xors;
+}
+
+const std::vector<Var>& CNF::get_projection() const {
+    return projection;
+}
+
+void CNF::set_projection(std::vector<Var> &&vars) {
+    projection = std::move(vars);
+    for (auto v : projection) declare(index(v));
+}
+
 Clause* CNF::get(const int idx) {
     return clauses[idx];
 }
 
-void CNF::remove_learnt_clauses() {
-    std::vector<Clause*> buf;
-    buf.reserve(original);
-    for (int i = 0; i < original; i++) buf.push_back(clauses[i]);
+void CNF::remove_learnt_clauses(const Valuation *va, const std::uint64_t keep_lbd) {
+    int j = original;
     for (int i = original; i < int(clauses.size()); i++) {
         auto c = clauses[i];
-        (c->get_pseudo_LBD() <= 3 ? buf : removed).push_back(c);
+        const bool locked = va->reason(var(c->get(0))) == c;
+        if (locked || c->get_pseudo_LBD() <= keep_lbd) {
+            c->cnf_idx = j;
+            clauses[j++] = c;
+            continue;
+        }
+        c->type = ClauseType::Removed;
+        const int b = floor_log2(c->capacity());
+        if (int(removed.size()) <= b) removed.resize(b + 1);
+        removed[b].push_back(c);
+    }
+    clauses.resize(j);
+}
+
+void CNF::reserve_learnts(const int n) {
+    const auto total = std::accumulate(ALL(learnt_sizes), std::uint64_t(0));
+    const int more = n - get_learnt_clause_num();
+    if (0 < total && 0 < more) {
+        clauses.reserve(original + n);
+        if (removed.size() < learnt_sizes.size()) removed.resize(learnt_sizes.size());
+        // new_learnt() takes a clause of the bucket it needs or above, so compare the
+        // suffix sums; clauses grow longer during the search, so a quarter of those of
+        // each bucket count for the next one as well
+        std::uint64_t wanted = 0, have = 0;
+        for (int b = int(learnt_sizes.size()) - 1; 0 <= b; b--) {
+            wanted += learnt_sizes[b];
+            have += removed[b].size();
+            const auto longer = (b == 0 ? 0 : learnt_sizes[b - 1] / 4);
+            const auto want = ((wanted + longer) * more + total - 1) / total;
+            for (; have < want; have++) {
+                auto c = new Clause(raw_clause());
+                c->raw().reserve(std::size_t(1) << b);
+                c->type = ClauseType::Removed;
+                removed[b].push_back(c);
+            }
+        }
     }
-    std::swap(clauses, buf);
+    learnt_sizes.fill(0);
 }
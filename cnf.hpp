@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <stack>
 #include <optional>
@@ -8,95 +9,187 @@
 template <typename T>
 using vstack = std::stack<T, std::vector<T>>;
 
-// enum class Var : std::int32_t { };
-// enum class Literal : std::uint32_t { };
+// Variables are numbered from 1 as in DIMACS.
+// A literal packs its variable and sign as 2 * var + sign (sign = 1 for negation),
+// so both polarities of a variable are adjacent and literals index flat arrays.
+enum class Var : std::int32_t { };
+enum class Literal : std::uint32_t { };
 
-using raw_clause = std::vector<int>;
+constexpr int index(const Var v) {
+    return static_cast<int>(v);
+}
 
-enum class PValue {
+constexpr int index(const Literal p) {
+    return static_cast<int>(p);
+}
+
+constexpr Literal make_lit(const Var v, const bool neg) {
+    return Literal((static_cast<std::uint32_t>(v) << 1) | std::uint32_t(neg));
+}
+
+constexpr Var var(const Literal p) {
+    return Var(static_cast<std::uint32_t>(p) >> 1);
+}
+
+constexpr bool is_neg(const Literal p) {
+    return static_cast<std::uint32_t>(p) & 1;
+}
+
+constexpr Literal operator~(const Literal p) {
+    return Literal(static_cast<std::uint32_t>(p) ^ 1);
+}
+
+constexpr Literal from_dimacs(const int x) {
+    return make_lit(Var(x < 0 ? -x : x), x < 0);
+}
+
+constexpr int to_dimacs(const Literal p) {
+    return is_neg(p) ? -index(var(p)) : index(var(p));
+}
+
+using raw_clause = std::vector<Literal>;
+
+enum class PValue : std::int8_t {
     TRUE = 1,
     FALSE = -1,
     BOTTOM = 0,
 };
 
-enum class ClauseState {
-    Unknown,
-    SAT,
-    UNSAT,
-    Unit,
-};
+// false for bytes of damaged input which are none of the values
+constexpr bool is_pvalue(const PValue x) {
+    return x == PValue::TRUE || x == PValue::FALSE || x == PValue::BOTTOM;
+}
 
 enum class ClauseType {
     Original,
     Learnt,
     Removed,
+    Explanation,  // reason of a literal implied by a cardinality constraint
 };
 
-bool match(const int p, const PValue v);
+struct Clause;
 
 struct Valuation {
     Valuation(const int size_);
-    PValue get_value(const int p) const;
-    int decided(const int p) const;
-    void assign(const int p, const PValue v, const int dl);
-    void imply(const int p, const int dl);
-    void reset(const int p);
+    PValue get_value(const Var v) const;
+    PValue get_value(const Literal p) const;  // value of the literal, not of its variable
+    int decided(const Var v) const;
+    int decided(const Literal p) const;
+    void assign(const Var x, const PValue v, const int dl);
+    void imply(const Literal p, const int dl, Clause *reason);
+    void reset(const Var v);
     int get_pnum() const;
-    PValue get_cache(const int p) const;
-    bool was_implied(const int p) const;
+    void grow(const int n);  // variables up to n, the new ones unassigned
+    PValue get_cache(const Var v) const;
+    void set_cache(const Var v, const PValue p);
+    bool was_implied(const Var v) const;
+    Clause* reason(const Var v) const;
 
 private:
+    // everything but the value of a variable, kept together so that
+    // assigning or resetting a variable touches a single cache line
+    struct var_data {
+        Clause *reason;
+        int dl;
+        PValue cache;
+    };
+
     int size;
-    std::vector<PValue> sigma, cache;
-    std::vector<int> dl_v;
-    std::vector<int> implied;
+    // indexed by Literal: truth test of a literal is one byte load
+    std::vector<PValue> sigma;
+    std::vector<var_data> data;
+};
+
+// Marks the decision levels already counted by an LBD computation.
+// Moving to the next round invalidates every mark at once, so nothing has to be cleared.
+struct LevelStamp {
+    LevelStamp() = delete;
+    LevelStamp(const int pnum);
+
+    void next();
+    bool mark(const int dl);  // false if dl was already marked in this round
+    void grow(const int pnum);
+
+private:
+    std::uint32_t round;
+    std::vector<std::uint32_t> stamp;
 };
 
 struct Clause {
-    ClauseState state;
     ClauseType type;
     int cnf_idx;
 
     Clause(raw_clause clause_);
-    Clause(raw_clause clause_, const Valuation *va);  // learnt clause
+    Clause(const raw_clause &clause_, const Valuation *va, LevelStamp &stamp);  // learnt clause
 
+    // The first two literals are the watched ones. A clause which is the reason
+    // of an assignment keeps the implied literal at position 0.
     const raw_clause& raw() const;
-    int get(const int idx) const;
+    raw_clause& raw();
+    Literal get(const int idx) const;
     int size() const;
-   
-    void update(const Valuation *va, const int dl);
-    std::pair<int, int> get_watch() const;
-    std::optional<int> unit() const;
-    void rollback(const int fst, const int last, ClauseState state);
+    std::size_t capacity() const;
+
+    // reuses the storage of a removed clause for a new learnt clause
+    void relearn(const raw_clause &clause_, const Valuation *va, LevelStamp &stamp);
 
     std::uint64_t get_LBD() const;
     std::uint64_t get_pseudo_LBD() const;
-    void recalc_LBD(const Valuation *va);
+    void recalc_LBD(const Valuation *va, LevelStamp &stamp);
+    void set_LBD(const std::uint64_t lbd, const std::uint64_t pseudo);  // restored from a checkpoint
 
 private:
     raw_clause clause;
-    int fst, last;
     std::uint64_t LBD, pseudo_LBD;
 
-    void update_state(const Valuation *va);
-    std::uint64_t calc_LBD(const Valuation *va) const;
+    std::uint64_t calc_LBD(const Valuation *va, LevelStamp &stamp) const;
+};
+
+// at most k of lits are true
+struct AtMost {
+    raw_clause lits;
+    int k;
+};
+
+// falsifying lits costs weight
+struct SoftClause {
+    raw_clause lits;
+    std::uint64_t weight;
 };
 
 struct CNF {
-    CNF(std::vector<raw_clause> clauses_);
+    // clauses_ keeps its capacity, its elements are moved
+    CNF(std::vector<raw_clause> &&clauses_, std::vector<AtMost> &&cards_ = { }, std::vector<raw_clause> &&xors_ = { });
 
     void add(Clause *c);
-    void remove(Clause *c);
+    void add_original(Clause *c);  // an original clause added after solving has started
+    Clause* new_learnt(const raw_clause &r, const Valuation *va, LevelStamp &stamp);
     int size() const;
     int get_pnum() const;
+    void declare(const int n);  // variables up to n exist even if no constraint contains them
     Clause* get(const int idx);
     int get_learnt_clause_num() const;
-    void remove_learnt_clauses();
+    const std::vector<AtMost>& get_cards() const;
+    const std::vector<raw_clause>& get_xors() const;  // the XOR of the literals is true
+    // the variables which tell models apart when enumerating, all of them if empty
+    const std::vector<Var>& get_projection() const;
+    void set_projection(std::vector<Var> &&vars);
+    // keeps the learnt clauses which are reasons or of pseudo LBD at most keep_lbd
+    void remove_learnt_clauses(const Valuation *va, const std::uint64_t keep_lbd);
+    // makes room for n learnt clauses in all: the removed clauses are topped up to cover
+    // the new ones, in the sizes of those learnt since the last call
+    void reserve_learnts(const int n);
     void free();
 
 private:
     int pnum;
     int original;
     std::vector<Clause*> clauses;
-    std::vector<Clause*> removed;
+    std::vector<AtMost> cards;
+    std::vector<raw_clause> xors;
+    std::vector<Var> projection;
+    // removed learnt clauses, bucketed by log2 of their capacity
+    std::vector<std::vector<Clause*>> removed;
+    // learnt clauses by log2 of the capacity they need, since reserve_learnts()
+    std::array<std::uint64_t, 32> learnt_sizes;
 };
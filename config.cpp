@@ -0,0 +1,126 @@
+#include "config.hpp"
+#include <functional>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+struct option {
+    std::string key;
+    std::function<bool(config&, const std::string&)> set;
+    std::function<std::string(const config&)> get;
+};
+
+// the whole of s, and nothing else, is a value of T which is at least lo
+template <typename T>
+bool read_value(const std::string &s, T &v, const T lo) {
+    std::istringstream ss(s);
+    T x;
+    if (!(ss >> x) || !(ss >> std::ws).eof() || x < lo) return false;
+    // a minus sign wraps around for unsigned types instead of failing
+    if (std::is_unsigned<T>::value && s.find('-') != std::string::npos) return false;
+    v = x;
+    return true;
+}
+
+template <typename T>
+std::string show(const T v) {
+    std::ostringstream ss;
+    ss << v;
+    return ss.str();
+}
+
+// an option of the field of the config which g picks
+template <typename G>
+option number(const std::string &key, G g, const double lo) {
+    using T = std::remove_reference_t<decltype(g(std::declval<config&>()))>;
+    return option {
+        key,
+        [=](config &c, const std::string &s) { return read_value(s, g(c), T(lo)); },
+        [=](const config &c) { return show(g(c)); },
+    };
+}
+
+#define FIELD(F) [](auto &c) -> auto& { return c.F; }
+
+const char* heuristic_name(const Heuristic h) {
+    switch (h) {
+        case Heuristic::LRB: return "lrb";
+        case Heuristic::CHB: return "chb";
+        case Heuristic::Switch: return "switch";
+        default: return "vsids";
+    }
+}
+
+const std::vector<option>& options() {
+    static const std::vector<option> ret {
+        option {
+            "heuristic",
+            [](config &c, const std::string &s) {
+                for (auto h : { Heuristic::VSIDS, Heuristic::LRB, Heuristic::CHB, Heuristic::Switch }) {
+                    if (s != heuristic_name(h)) continue;
+                    c.branching.heuristic = h;
+                    return true;
+                }
+                return false;
+            },
+            [](const config &c) { return std::string(heuristic_name(c.branching.heuristic)); },
+        },
+        number("vsids_div", FIELD(branching.vsids_div), 2),
+        number("vsids_span", FIELD(branching.vsids_span), 1),
+        number("chrono", FIELD(chrono), 0),
+        number("restart_window", FIELD(search.restart_window), 1),
+        number("restart_margin", FIELD(search.restart_margin), 0.0),
+        number("luby_unit", FIELD(search.luby_unit), 1),
+        number("reduce_base", FIELD(search.reduce_base), 0),
+        number("reduce_step", FIELD(search.reduce_step), 0),
+        number("keep_lbd", FIELD(search.keep_lbd), 0),
+        number("rephase_interval", FIELD(search.rephase_interval), 1),
+        number("walk_flips", FIELD(search.walk_flips), 0),
+        number("chrono_conflicts", FIELD(search.chrono_conflicts), 0),
+    };
+    return ret;
+}
+
+std::string trim(const std::string &s) {
+    const auto b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return "";
+    return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+}
+
+bool set_option(config &c, const std::string &key, const std::string &value) {
+    for (const auto &o : options()) {
+        if (o.key == key) return o.set(c, value);
+    }
+    return false;
+}
+
+bool set_option(config &c, const std::string &assignment) {
+    const auto eq = assignment.find('=');
+    if (eq == std::string::npos) return false;
+    return set_option(c, trim(assignment.substr(0, eq)), trim(assignment.substr(eq + 1)));
+}
+
+std::string get_option(const config &c, const std::string &key) {
+    for (const auto &o : options()) {
+        if (o.key == key) return o.get(c);
+    }
+    return "";
+}
+
+int read_config(std::istream &in, config &c) {
+    std::string s;
+    for (int line = 1; std::getline(in, s); line++) {
+        s = trim(s.substr(0, s.find('#')));
+        if (s.empty()) continue;
+        if (!set_option(c, s)) return line;
+    }
+    return 0;
+}
+
+void write_config(std::ostream &out, const config &c) {
+    for (const auto &o : options()) out << o.key << " = " << o.get(c) << '\n';
+}
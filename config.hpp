@@ -0,0 +1,36 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "cdcl/cdcl.hpp"
+
+// Everything a configuration file sets, one "key = value" per line, '#' starting a comment:
+// heuristic           vsids, lrb, chb or switch
+// vsids_div           VSIDS divides every score by this ...
+// vsids_span          ... once per these conflicts
+// chrono              backjumps over more levels backtrack a single one; 0 disables
+// restart_window ...  the fields of cdcl::params by their names
+struct config {
+    branch_options branching;
+    int chrono;
+    cdcl::params search;
+};
+
+constexpr config default_config { cdcl::default_branching, 0, cdcl::default_params };
+
+// false for an unknown key or a malformed or out-of-range value, which leaves c as it was
+bool set_option(config &c, const std::string &key, const std::string &value);
+bool set_option(config &c, const std::string &assignment);  // "key=value"
+std::string get_option(const config &c, const std::string &key);
+// 0, or the number of the first line which set_option() rejects
+int read_config(std::istream &in, config &c);
+void write_config(std::ostream &out, const config &c);
+
+// sets up a cdcl::Solver of any policy to run with c
+template <typename S>
+void configure(S &solver, const config &c) {
+    solver.set_branching(c.branching);
+    solver.set_chrono(c.chrono);
+    solver.set_params(c.search);
+}
@@ -0,0 +1,573 @@
+#include "dist.hpp"
+#include "util.hpp"
+#include "output.hpp"
+#include "cdcl/cdcl.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+namespace {
+
+constexpr std::uint64_t slice = 2000;  // conflicts between two exchanges of a worker
+constexpr int share_size = 8;          // learnt clauses sent to the others: size and LBD at most
+constexpr std::uint64_t share_lbd = 2;
+constexpr std::size_t max_backlog = 1 << 20;  // a worker behind by more bytes misses shared clauses
+constexpr std::size_t max_shared = 1 << 20;   // bytes of recent shared clauses kept for late joiners
+
+/* ========== sockets ========== */
+
+bool is_tcp(const std::string &addr) {
+    const auto colon = addr.rfind(':');
+    if (colon == std::string::npos || colon + 1 == addr.size() || addr.find('/') != std::string::npos) return false;
+    return std::all_of(std::begin(addr) + colon + 1, std::end(addr), [](const char c) { return '0' <= c && c <= '9'; });
+}
+
+addrinfo* resolve(const std::string &addr, const bool passive) {
+    const auto colon = addr.rfind(':');
+    const auto host = addr.substr(0, colon), port = addr.substr(colon + 1);
+    addrinfo hints { };
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (passive) hints.ai_flags = AI_PASSIVE;
+    addrinfo *ret = nullptr;
+    if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &ret) != 0) return nullptr;
+    return ret;
+}
+
+bool unix_address(const std::string &path, sockaddr_un &addr) {
+    addr = sockaddr_un { };
+    addr.sun_family = AF_UNIX;
+    if (sizeof(addr.sun_path) <= path.size()) return false;
+    std::strcpy(addr.sun_path, path.c_str());
+    return true;
+}
+
+int listen_on(const std::string &addr) {
+    if (!is_tcp(addr)) {
+        sockaddr_un sa;
+        if (!unix_address(addr, sa)) return -1;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        ::unlink(addr.c_str());
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0 || ::listen(fd, 64) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    auto info = resolve(addr, true);
+    int fd = -1;
+    for (auto a = info; a != nullptr && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        const int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (::bind(fd, a->ai_addr, a->ai_addrlen) < 0 || ::listen(fd, 64) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (info != nullptr) ::freeaddrinfo(info);
+    return fd;
+}
+
+int connect_once(const std::string &addr) {
+    if (!is_tcp(addr)) {
+        sockaddr_un sa;
+        if (!unix_address(addr, sa)) return -1;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    auto info = resolve(addr, false);
+    int fd = -1;
+    for (auto a = info; a != nullptr && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (::connect(fd, a->ai_addr, a->ai_addrlen) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (info != nullptr) ::freeaddrinfo(info);
+    return fd;
+}
+
+// workers may be started before the coordinator listens
+int connect_to(const std::string &addr) {
+    for (int i = 0; i < 100; i++) {
+        const int fd = connect_once(addr);
+        if (0 <= fd) return fd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return -1;
+}
+
+bool send_all(const int fd, const std::string &s) {
+    std::size_t done = 0;
+    while (done < s.size()) {
+        const auto n = ::write(fd, s.data() + done, s.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+
+/* ========== LineReader ========== */
+
+// buffered lines of a socket, read either blocking or only as far as data has arrived
+struct LineReader {
+    LineReader() = delete;
+    LineReader(const int fd_)
+        : fd(fd_), b(0)
+    {
+    }
+
+    // one read(2); false at the end of the stream
+    bool fill() {
+        char tmp[1 << 16];
+        const auto n = ::read(fd, tmp, sizeof(tmp));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+        if (b == buf.size()) {
+            buf.clear();
+            b = 0;
+        }
+        buf.append(tmp, n);
+        return true;
+    }
+
+    bool ready() const {
+        pollfd p { fd, POLLIN, 0 };
+        return 0 < ::poll(&p, 1, 0);
+    }
+
+    // the next complete line if one has been buffered
+    bool next(std::string &s) {
+        const auto nl = buf.find('\n', b);
+        if (nl == std::string::npos) return false;
+        s.assign(buf, b, nl - b);
+        b = nl + 1;
+        return true;
+    }
+
+    bool read_line(std::string &s) {
+        while (!next(s)) {
+            if (!fill()) return false;
+        }
+        return true;
+    }
+
+    bool read_exact(std::string &s, const std::size_t n) {
+        while (buf.size() - b < n) {
+            if (!fill()) return false;
+        }
+        s.assign(buf, b, n);
+        b += n;
+        return true;
+    }
+
+private:
+    const int fd;
+    std::string buf;
+    std::size_t b;
+};
+
+std::string lits_line(const std::string &head, const std::vector<int> &lits) {
+    std::string ret = head;
+    for (auto x : lits) {
+        ret += ' ';
+        ret += std::to_string(x);
+    }
+    ret += " 0\n";
+    return ret;
+}
+
+std::string lits_line(const std::string &head, const raw_clause &lits) {
+    std::vector<int> v;
+    for (auto p : lits) v.push_back(to_dimacs(p));
+    return lits_line(head, v);
+}
+
+// the literals of "<tag> [id] l1 ... 0"; false unless every variable is in [1, pn]
+bool read_lits(std::istringstream &ss, const int pn, raw_clause &out) {
+    out.clear();
+    int x;
+    while (ss >> x && x != 0) {
+        if (x < -pn || pn < x) return false;
+        out.push_back(from_dimacs(x));
+    }
+    return true;
+}
+
+
+/* ========== coordinator ========== */
+
+// The socket of a worker is non-blocking: messages are queued and written as far as the
+// worker takes them, so that a worker busy sending its own clauses cannot stall the
+// coordinator while it forwards those of the others.
+struct worker_conn {
+    int fd;
+    LineReader reader;
+    int job;          // cube being solved, -1 when idle
+    std::string out;  // queued for the worker, written up to sent
+    std::size_t sent;
+
+    std::size_t pending() const {
+        return out.size() - sent;
+    }
+
+    void post(const std::string &s) {
+        out += s;
+    }
+
+    // false once the worker is gone
+    bool flush() {
+        while (sent < out.size()) {
+            const auto n = ::write(fd, out.data() + sent, out.size() - sent);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) return false;
+            sent += n;
+        }
+        if (sent == out.size() || max_backlog < sent) {
+            out.erase(0, sent);
+            sent = 0;
+        }
+        return true;
+    }
+};
+
+// the 2^depth sign combinations of the depth most frequent variables
+std::vector<raw_clause> make_cubes(const std::vector<raw_clause> &clauses, const int pn, int depth) {
+    std::vector<int> occ(pn + 1, 0), vars;
+    for (const auto &c : clauses) for (auto p : c) occ[index(var(p))]++;
+    for (int i = 1; i <= pn; i++) vars.push_back(i);
+    depth = std::min(depth, pn);
+    std::partial_sort(std::begin(vars), std::begin(vars) + depth, std::end(vars),
+                      [&](const int a, const int b) { return occ[a] > occ[b]; });
+    std::vector<raw_clause> ret(std::size_t(1) << depth);
+    for (std::size_t m = 0; m < ret.size(); m++) {
+        for (int k = 0; k < depth; k++) ret[m].push_back(make_lit(Var(vars[k]), (m >> k) & 1));
+    }
+    return ret;
+}
+
+// configuration of the i-th worker to connect
+std::string config_line(const int i) {
+    static const char *heuristics[] = { "vsids", "lrb", "chb", "switch" };
+    return std::string("config ") + heuristics[i % 4] + " " + (i / 4 % 2 == 0 ? "0" : "100") + " " + std::to_string(i) + "\n";
+}
+
+pid_t spawn_worker(const std::string &addr) {
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        ::execl("/proc/self/exe", "main", "-w", addr.c_str(), static_cast<char*>(nullptr));
+        std::_Exit(127);
+    }
+    return pid;
+}
+
+}
+
+int coordinate(const std::string &addr, const std::string &text, const dist_options &opt, const bool print) {
+    int pn = 0;
+    std::vector<raw_clause> clauses;
+    if (!parse_buffer(text.data(), text.data() + text.size(), pn, clauses)) {
+        std::cerr << "malformed CNF" << std::endl;
+        return 1;
+    }
+    const bool portfolio = (opt.cube_depth == 0);
+    const auto cubes = (portfolio ? std::vector<raw_clause>(1) : make_cubes(clauses, pn, opt.cube_depth));
+    clauses.clear();
+
+    const int lfd = listen_on(addr);
+    if (lfd < 0) {
+        std::cerr << "cannot listen on " << addr << std::endl;
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::set<pid_t> children;
+    int respawns = 2 * opt.workers;
+    for (int i = 0; i < opt.workers; i++) children.insert(spawn_worker(addr));
+
+    const std::string header = "cnf " + std::to_string(text.size()) + "\n";
+    std::string shared;  // every clause shared so far, for the workers joining later
+    std::vector<std::unique_ptr<worker_conn>> workers;
+    std::deque<int> todo;
+    std::vector<char> refuted(cubes.size(), 0);
+    int left = cubes.size(), joined = 0;
+    for (int i = 0; i < int(cubes.size()); i++) todo.push_back(i);
+    cdcl::Result res = cdcl::Result::Unknown;
+    std::vector<int> model;
+
+    // hands out the next cube which is not refuted yet
+    auto assign = [&](worker_conn &w) {
+        if (portfolio) {
+            w.job = 0;
+        } else {
+            while (!todo.empty() && refuted[todo.front()]) todo.pop_front();
+            if (todo.empty()) return;
+            w.job = todo.front();
+            todo.pop_front();
+        }
+        w.post(lits_line("cube " + std::to_string(w.job), cubes[w.job]));
+    };
+    // the cube of a lost worker is solved by another one
+    auto lose = [&](worker_conn &w) {
+        ::close(w.fd);
+        w.fd = -1;
+        if (!portfolio && w.job != -1 && !refuted[w.job]) todo.push_front(w.job);
+        w.job = -1;
+    };
+    // a cube which contains a refuted core is refuted too
+    auto refute = [&](const raw_clause &core) {
+        for (int i = 0; i < int(cubes.size()); i++) {
+            if (refuted[i]) continue;
+            const bool sub = std::all_of(ALL(core), [&](const Literal p) {
+                return std::find(ALL(cubes[i]), p) != std::end(cubes[i]);
+            });
+            if (!sub) continue;
+            refuted[i] = 1;
+            left--;
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::string line;
+    raw_clause lits;
+    bool deserted = false;
+    while (res == cdcl::Result::Unknown) {
+        if (opt.seconds != 0) {
+            const std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+            if (opt.seconds <= d.count()) break;
+        }
+        // local workers which died, before or after connecting, are replaced
+        pid_t pid;
+        while (0 < (pid = ::waitpid(-1, nullptr, WNOHANG))) {
+            children.erase(pid);
+            if (0 < respawns--) children.insert(spawn_worker(addr));
+        }
+        // without a time limit nothing would end the wait for local workers which keep dying
+        if (0 < opt.workers && children.empty() && workers.empty()) {
+            deserted = true;
+            break;
+        }
+
+        std::vector<pollfd> fds { pollfd { lfd, POLLIN, 0 } };
+        for (auto &w : workers) fds.push_back(pollfd { w->fd, short(POLLIN | (w->pending() != 0 ? POLLOUT : 0)), 0 });
+        if (::poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR) break;
+
+        if (fds[0].revents & POLLIN) {
+            const int fd = ::accept(lfd, nullptr, nullptr);
+            if (0 <= fd) {
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                workers.push_back(std::make_unique<worker_conn>(worker_conn { fd, LineReader(fd), -1, "", 0 }));
+                auto &w = *workers.back();
+                w.post(header);
+                w.post(text);
+                w.post(config_line(joined++));
+                w.post(shared);
+                assign(w);
+            }
+        }
+
+        for (std::size_t k = 1; k < fds.size() && res == cdcl::Result::Unknown; k++) {
+            if ((fds[k].revents & (POLLIN | POLLHUP | POLLERR)) == 0) continue;
+            auto &w = *workers[k - 1];
+            bool alive = w.reader.fill();
+            while (alive && res == cdcl::Result::Unknown && w.reader.next(line)) {
+                std::istringstream ss(line);
+                std::string tag;
+                int id = 0;
+                ss >> tag;
+                if (tag == "hello") continue;
+                if (tag == "clause") {
+                    if (!read_lits(ss, pn, lits)) continue;
+                    line += '\n';
+                    shared += line;
+                    // late joiners get the more recent half once there are too many
+                    if (max_shared < shared.size()) shared.erase(0, shared.find('\n', shared.size() / 2) + 1);
+                    for (auto &o : workers) {
+                        if (o.get() != &w && 0 <= o->fd && o->pending() <= max_backlog) o->post(line);
+                    }
+                    continue;
+                }
+                ss >> id;
+                if (!read_lits(ss, pn, lits) || id < 0 || int(cubes.size()) <= id) continue;
+                if (tag == "sat") {
+                    res = cdcl::Result::SAT;
+                    for (auto p : lits) model.push_back(to_dimacs(p));
+                } else if (tag == "unsat") {
+                    // an empty core refutes the formula
+                    refute(lits);
+                    if (lits.empty()) left = 0;
+                    if (left == 0) res = cdcl::Result::UNSAT;
+                    w.job = -1;
+                    assign(w);
+                }
+            }
+            if (!alive) lose(w);
+        }
+        for (auto &w : workers) {
+            if (0 <= w->fd && w->job == -1 && !todo.empty()) assign(*w);
+        }
+        for (auto &w : workers) {
+            if (0 <= w->fd && !w->flush()) lose(*w);
+        }
+        workers.erase(std::remove_if(ALL(workers), [](const std::unique_ptr<worker_conn> &w) { return w->fd < 0; }), std::end(workers));
+    }
+
+    // workers which miss the stop see the connection close
+    for (auto &w : workers) {
+        w->post("stop\n");
+        w->flush();
+        ::close(w->fd);
+    }
+    ::close(lfd);
+    if (!is_tcp(addr)) ::unlink(addr.c_str());
+    for (auto p : children) ::kill(p, SIGTERM);
+    for (auto p : children) ::waitpid(p, nullptr, 0);
+
+    if (deserted) std::cerr << "every local worker died" << std::endl;
+    OutputBuffer out(res == cdcl::Result::SAT && print ? model_capacity(pn) : 64);
+    if (res == cdcl::Result::Unknown) {
+        print_unknown(out);
+    } else {
+        print_status(out, res == cdcl::Result::SAT);
+        if (res == cdcl::Result::SAT && print) {
+            Valuation va(pn);
+            for (auto x : model) va.assign(Var(std::abs(x)), x < 0 ? PValue::FALSE : PValue::TRUE, 0);
+            print_model(out, &va, pn);
+        }
+    }
+    out.flush(STDOUT_FILENO);
+    if (deserted) return 1;
+    return res == cdcl::Result::SAT ? 10 : res == cdcl::Result::UNSAT ? 20 : 0;
+}
+
+
+/* ========== worker ========== */
+
+bool work(const std::string &addr) {
+    const int fd = connect_to(addr);
+    if (fd < 0) return false;
+    std::signal(SIGPIPE, SIG_IGN);
+    LineReader reader(fd);
+    send_all(fd, "hello " + std::to_string(::getpid()) + "\n");
+
+    std::string line, text, name;
+    std::size_t bytes = 0;
+    if (!reader.read_line(line) || std::sscanf(line.c_str(), "cnf %zu", &bytes) != 1 || !reader.read_exact(text, bytes)) return false;
+    int pn = 0;
+    std::vector<raw_clause> clauses;
+    if (!parse_buffer(text.data(), text.data() + text.size(), pn, clauses)) return false;
+    int chrono = 0;
+    unsigned seed = 0;
+    {
+        if (!reader.read_line(line)) return false;
+        std::istringstream ss(line);
+        std::string tag;
+        ss >> tag >> name >> chrono >> seed;
+    }
+
+    CNF cnf(std::move(clauses));
+    cnf.declare(pn);
+    Valuation va(cnf.get_pnum());
+    branch_options branching = cdcl::default_branching;
+    if (name == "lrb") branching.heuristic = Heuristic::LRB;
+    else if (name == "chb") branching.heuristic = Heuristic::CHB;
+    else if (name == "switch") branching.heuristic = Heuristic::Switch;
+    bool ok = true;
+    cdcl::with_heuristic<cdcl::default_policy>(branching.heuristic, [&](auto p) {
+        cdcl::Solver<decltype(p)> solver(&cnf, &va);
+        solver.set_branching(branching);
+        solver.set_chrono(chrono);
+        // the first worker starts from the default phases, the others from random ones
+        if (seed != 0) {
+            std::mt19937 rng(seed);
+            for (int i = 1; i <= pn; i++) va.set_cache(Var(i), rng() % 2 ? PValue::TRUE : PValue::FALSE);
+        }
+        std::string learnts;
+        solver.set_export([&](const raw_clause &c) { learnts += lits_line("clause", c); }, share_size, share_lbd);
+
+        std::vector<raw_clause> imports;
+        raw_clause lits, cube;
+        bool stop = false;
+        // false when the coordinator is gone
+        auto handle = [&](const std::string &l) {
+            std::istringstream ss(l);
+            std::string tag;
+            ss >> tag;
+            if (tag == "clause" && read_lits(ss, pn, lits)) imports.push_back(lits);
+            if (tag == "stop") stop = true;
+        };
+
+        while (!stop && reader.read_line(line)) {
+            std::istringstream ss(line);
+            std::string tag;
+            int id = 0;
+            ss >> tag;
+            if (tag != "cube") {
+                handle(line);
+                continue;
+            }
+            ss >> id;
+            if (!read_lits(ss, pn, cube)) continue;
+
+            auto res = cdcl::Result::Unknown;
+            while (res == cdcl::Result::Unknown && !stop) {
+                // an import which makes the clauses unsatisfiable leads search() to UNSAT at once
+                for (const auto &c : imports) solver.add_clause(c);
+                imports.clear();
+                solver.set_limits(cdcl::limits { solver.get_statistics().conflicts + slice, 0 });
+                res = solver.search(cube);
+                ok = send_all(fd, learnts);
+                learnts.clear();
+                while (ok && res == cdcl::Result::Unknown && reader.ready()) {
+                    ok = reader.fill();
+                    while (ok && reader.next(line)) handle(line);
+                }
+                if (!ok) break;
+            }
+            if (!ok || stop) break;
+            if (res == cdcl::Result::SAT) {
+                std::vector<int> model;
+                for (int i = 1; i <= pn; i++) model.push_back(va.get_value(Var(i)) == PValue::FALSE ? -i : i);
+                ok = send_all(fd, lits_line("sat " + std::to_string(id), model));
+            } else {
+                // the core is empty once the clauses alone are unsatisfiable
+                ok = send_all(fd, lits_line("unsat " + std::to_string(id), solver.get_core()));
+            }
+            if (!ok) break;
+        }
+    });
+    cnf.free();
+    ::close(fd);
+    return ok;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+struct dist_options {
+    int workers;     // local worker processes started by the coordinator, 0 for none
+    int cube_depth;  // 2^depth cubes over the most frequent variables, 0 runs a portfolio
+    double seconds;  // 0 means no limit
+};
+
+// Coordinator / worker protocol, one text line per message except the formula:
+//   coordinator -> worker : "cnf <bytes>\n" + DIMACS text, "config <heuristic> <chrono> <seed>",
+//                           "cube <id> l1 ... 0", "clause l1 ... 0", "stop"
+//   worker -> coordinator : "hello <pid>", "clause l1 ... 0",
+//                           "sat <id> <model> 0", "unsat <id> <core> 0"
+// A portfolio sends the empty cube 0 to every worker, each with its own configuration;
+// cube mode hands the cubes out one at a time. Workers search in slices of conflicts
+// and between slices send their short learnt clauses and take in those of the others,
+// which the coordinator forwards, also to workers joining later. The coordinator never
+// blocks on a worker: a worker which falls behind misses clauses, and those kept for
+// later joiners are the most recent ones up to a bound. The cube of a worker which
+// disconnects goes back to the queue, and a local worker which dies is replaced, up to
+// twice as many times as there are local workers; once they are all gone the
+// coordinator answers UNKNOWN with exit code 1.
+// An address is "host:port" for TCP, anything else is the path of a Unix domain socket.
+
+// Solves the DIMACS text cnf with the workers connecting to addr and prints the answer
+// (the model only if print) as the other modes do; returns the exit code.
+int coordinate(const std::string &addr, const std::string &cnf, const dist_options &opt, const bool print);
+// Solves what the coordinator at addr sends until it says stop or disconnects.
+bool work(const std::string &addr);
@@ -11,7 +11,7 @@ std::optional<Valuation*> DPLL::solve_aux(const int p) {
     if (p == cnf->get_pnum() + 1) return va;
 
     for (auto v : { PValue::TRUE, PValue::FALSE }) {
-        va->assign(p, v, -1);
+        va->assign(Var(p), v, -1);
         auto opt = std::move(update());
         if (opt.has_value()) {
             auto res = solve_aux(p + 1);
@@ -19,7 +19,7 @@ std::optional<Valuation*> DPLL::solve_aux(const int p) {
             for (auto e : *opt) sat[e] = 0;
         }
     }
-    va->reset(p);
+    va->reset(Var(p));
     return std::nullopt;
 }
 
@@ -39,7 +39,7 @@ std::optional<std::vector<int>> DPLL::update() {
             const auto v = va->get_value(p);
             if (v == PValue::BOTTOM) {
                 unknown = true;
-            } else if (match(p, v)) {
+            } else if (v == PValue::TRUE) {
                 res.push_back(i);
                 sat[i] = 1;
                 break;
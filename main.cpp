@@ -1,33 +1,410 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <cassert>
+#include <csignal>
 #include <unistd.h>
 #include "util.hpp"
+#include "config.hpp"
+#include "output.hpp"
+#include "alloc.hpp"
+#include "batch.hpp"
+#include "tune.hpp"
+#include "server.hpp"
+#include "dist.hpp"
 #include "dpll/dpll.hpp"
+#include "sls/sls.hpp"
 #include "cdcl/cdcl.hpp"
+#include "cdcl/component.hpp"
+#include "maxsat/maxsat.hpp"
+#include "mus/mus.hpp"
+#include "backbone/backbone.hpp"
 
-auto solve(CNF *cnf, Valuation *va, bool dpll) {
-    if (dpll) {
-        return DPLL(cnf, va).solve();
-    } else {
-        return cdcl::CDCL(cnf, va).solve();
+void print_statistics(const cdcl::statistics &st) {
+    std::cerr << "c conflicts    : " << st.conflicts << '\n'
+              << "c decisions    : " << st.decisions << '\n'
+              << "c propagations : " << st.propagations << '\n'
+              << "c restarts     : " << st.restarts << '\n'
+              << "c reductions   : " << st.reductions << '\n'
+              << "c rephases     : " << st.rephases << '\n'
+              << "c walks        : " << st.walks << '\n';
+#ifdef ALLOC_STATS
+    std::cerr << "c allocations  : " << alloc_count() << '\n';
+    if (st.warm && st.warmup_conflicts < st.conflicts) {
+        const auto allocs = st.search_allocs - st.warmup_allocs - st.reduce_allocs;
+        const auto conflicts = st.conflicts - st.warmup_conflicts;
+        std::cerr << "c allocations per conflict after warm-up, outside reductions : "
+                  << double(allocs) / conflicts << " (" << allocs << " / " << conflicts << ")\n"
+                  << "c allocations of reductions after warm-up : " << st.reduce_allocs << '\n';
     }
+#endif
+}
+
+struct checkpoint_options {
+    std::string path;  // resumed from if it exists, empty for none
+    double seconds;    // between checkpoints written at restarts
+};
+
+// set by SIGINT / SIGTERM when checkpointing: the search stops and writes a last checkpoint
+std::atomic<bool> interrupted(false);
+
+void interrupt(int) {
+    interrupted = true;
+}
+
+// the prebuilt instantiations of cdcl::Solver
+enum class Policy {
+    Default,
+    Luby,
+    Recursive,
+    Keep,
+    Drat,
+};
+
+enum class Mode {
+    DPLL,
+    CDCL,
+    SLS,
+    MaxSAT,
+    Backbone,
+};
+
+template <typename P>
+std::optional<Valuation*> solve_cdcl(CNF *cnf, Valuation *va, bool stat, const config &cfg, int threads,
+                                     const checkpoint_options &ckpt, std::ostream *proof) {
+    cdcl::Solver<P> solver(cnf, va);
+    configure(solver, cfg);
+    solver.set_check_threads(threads);
+    solver.set_proof(proof);
+    if (stat) solver.set_perf_log(&std::cerr);
+    if (!ckpt.path.empty()) {
+        std::ifstream in(ckpt.path, std::ios::binary);
+        if (in && !solver.load(in)) std::cerr << "c " << ckpt.path << " is not a checkpoint of this formula, starting over" << std::endl;
+        solver.set_checkpoint(ckpt.path, ckpt.seconds);
+        solver.set_cancel(&interrupted);
+        std::signal(SIGINT, interrupt);
+        std::signal(SIGTERM, interrupt);
+    }
+    auto res = solver.solve();
+    if (interrupted && !res.has_value()) {
+        solver.write_checkpoint();
+        std::cerr << "c interrupted, checkpoint written to " << ckpt.path << std::endl;
+    }
+    if (stat) {
+        print_statistics(solver.get_statistics());
+        solver.get_perf().summary(std::cerr);
+    }
+    return res;
+}
+
+std::optional<Valuation*> solve(CNF *cnf, Valuation *va, Mode mode, bool stat, const config &cfg, double seconds, int threads, const checkpoint_options &ckpt, Policy policy, std::ostream *proof) {
+    switch (mode) {
+        case Mode::DPLL:
+            return DPLL(cnf, va).solve();
+        case Mode::SLS:
+            return SLS(cnf, cnf->size()).solve(va, seconds);
+        default:
+            break;
+    }
+    auto run = [&](auto p) { return solve_cdcl<decltype(p)>(cnf, va, stat, cfg, threads, ckpt, proof); };
+    const auto h = cfg.branching.heuristic;
+    switch (policy) {
+        case Policy::Luby:
+            return cdcl::with_heuristic<cdcl::luby_policy>(h, run);
+        case Policy::Recursive:
+            return cdcl::with_heuristic<cdcl::recursive_policy>(h, run);
+        case Policy::Keep:
+            return cdcl::with_heuristic<cdcl::keep_policy>(h, run);
+        case Policy::Drat:
+            return cdcl::with_heuristic<cdcl::drat_policy>(h, run);
+        default:
+            return cdcl::with_heuristic<cdcl::default_policy>(h, run);
+    }
+}
+
+// Solves the variable-disjoint components of the formula apart, threads of them at a time.
+std::optional<Valuation*> solve_split(CNF *cnf, Valuation *va, bool stat, const config &cfg, int threads) {
+    cdcl::Components comps(cnf);
+    if (stat) std::cerr << "c components   : " << comps.size() << '\n';
+    const auto res = comps.solve(va, cdcl::component_options { threads, cdcl::limits { 0, 0 }, cfg.chrono, cfg.branching, cfg.search });
+    if (stat) print_statistics(comps.get_statistics());
+    if (res != cdcl::Result::SAT) return std::nullopt;
+    return va;
+}
+
+// Streams every model, projected onto cnf->get_projection() if it has one, until there
+// is none left or limit models (0: no limit) have been printed; returns their number.
+template <typename P>
+std::uint64_t enumerate(CNF *cnf, Valuation *va, bool print, bool stat, const config &cfg, const std::uint64_t limit) {
+    const auto &proj = cnf->get_projection();
+    cdcl::Solver<P> solver(cnf, va);
+    configure(solver, cfg);
+    OutputBuffer out(model_capacity(cnf->get_pnum()));
+    std::uint64_t count = 0;
+    while (limit == 0 || count < limit) {
+        if (solver.search() != cdcl::Result::SAT) break;
+        if (count++ == 0) print_status(out, true);
+        if (print) {
+            if (proj.empty()) print_model(out, va, cnf->get_pnum());
+            else print_model(out, va, proj);
+        }
+        out.flush(STDOUT_FILENO);
+        if (!solver.block_model()) break;
+    }
+    if (count == 0) print_status(out, false);
+    out.put("c models ");
+    out.put(std::to_string(count).c_str());
+    out.put('\n');
+    out.flush(STDOUT_FILENO);
+    if (stat) print_statistics(solver.get_statistics());
+    return count;
+}
+
+// Reads WCNF and prints "o <cost>" for every better model, then "s OPTIMUM FOUND" with
+// the optimal model, "s SATISFIABLE" with the best one when seconds run out first,
+// "s UNSATISFIABLE" or "s UNKNOWN".
+template <typename P>
+int maxsat(std::istream &in, bool print, bool stat, const config &cfg, double seconds) {
+    int pn = 0;
+    std::vector<raw_clause> hard;
+    std::vector<SoftClause> soft;
+    if (!parse_wcnf(in, pn, hard, soft)) {
+        std::cerr << "malformed WCNF" << std::endl;
+        return 1;
+    }
+    auto cnf = new CNF(std::move(hard));
+    cnf->declare(pn);
+    Valuation va(cnf->get_pnum());
+    int ret = 0;
+    {
+        MaxSAT<P> solver(cnf, &va, std::move(soft));
+        solver.set_branching(cfg.branching);
+        solver.set_params(cfg.search);
+        solver.set_limits(cdcl::limits { 0, seconds });
+        solver.set_log(&std::cout);
+        solver.solve();
+        const auto ub = solver.get_upper();
+        OutputBuffer out(ub.has_value() && print ? model_capacity(pn) : 64);
+        if (solver.is_optimal()) {
+            out.put("s OPTIMUM FOUND\n");
+            ret = 30;
+        } else if (ub.has_value()) {
+            out.put("s SATISFIABLE\n");
+            ret = 10;
+        } else if (seconds == 0) {
+            print_status(out, false);
+            ret = 20;
+        } else {
+            print_unknown(out);
+        }
+        if (ub.has_value() && print) print_model(out, &va, pn);
+        std::cout.flush();
+        out.flush(STDOUT_FILENO);
+        if (stat) std::cerr << "c cores        : " << solver.cores() << '\n'
+                            << "c lower bound  : " << solver.get_lower() << '\n';
+    }
+    cnf->free();
+    delete cnf;
+    return ret;
+}
+
+// Solves with a selector per clause; UNSAT prints the clause indices of a core,
+// a minimal one if minimal, in place of the model.
+int solve_core(CNF *cnf, const int pn, bool print, bool stat, bool minimal) {
+    MUS mus(cnf);
+    const auto res = mus.solve();
+    if (res == cdcl::Result::UNSAT && minimal) mus.minimize();
+    OutputBuffer out(res == cdcl::Result::SAT && print ? model_capacity(pn) : 64);
+    if (res == cdcl::Result::Unknown) print_unknown(out);
+    else print_status(out, res == cdcl::Result::SAT);
+    if (res == cdcl::Result::SAT && print) print_model(out, mus.get_model(), pn);
+    if (res == cdcl::Result::UNSAT && print) print_core(out, mus.get_core());
+    out.flush(STDOUT_FILENO);
+    if (stat) {
+        print_statistics(mus.get_statistics());
+        std::cerr << "c core size    : " << mus.get_core().size() << '\n'
+                  << "c checks       : " << mus.checks() << '\n';
+    }
+    return res == cdcl::Result::SAT ? 10 : res == cdcl::Result::UNSAT ? 20 : 0;
+}
+
+// Prints the literals true in every model in place of a model; "c backbone ..." lines
+// follow the progress.
+template <typename P>
+int backbone(CNF *cnf, bool print, bool stat, const config &cfg, double seconds) {
+    Valuation va(cnf->get_pnum());
+    Backbone<P> bb(cnf, &va);
+    bb.set_limits(cdcl::limits { 0, seconds });
+    bb.set_branching(cfg.branching);
+    bb.set_params(cfg.search);
+    bb.set_log(&std::cout);
+    const auto res = bb.solve();
+    const auto lits = bb.get_backbone();
+    OutputBuffer out(res == cdcl::Result::SAT && print ? model_capacity(lits.size()) : 64);
+    if (res == cdcl::Result::Unknown) print_unknown(out);
+    else print_status(out, res == cdcl::Result::SAT);
+    if (res == cdcl::Result::SAT && print) print_literals(out, lits);
+    std::cout.flush();
+    out.flush(STDOUT_FILENO);
+    if (stat) {
+        print_statistics(bb.get_statistics());
+        std::cerr << "c backbone     : " << lits.size() << '\n'
+                  << "c checks       : " << bb.checks() << '\n';
+    }
+    return res == cdcl::Result::SAT ? 10 : res == cdcl::Result::UNSAT ? 20 : 0;
 }
 
 int main(int argc, char *argv[]) {
     bool queen = false;
-    std::optional<bool> dpll = std::nullopt;
+    int queens = 0;  // solves the built-in N-queens encoding instead of reading stdin
+    bool print = true;
+    bool stat = false;
+    config cfg = default_config;  // -F, -O, -H and -B apply in the order given
+    std::optional<std::uint64_t> all = std::nullopt;  // model enumeration and its limit
+    std::optional<bool> core = std::nullopt;  // prints an unsatisfiable core, minimal if true
+    std::optional<std::string> model_path = std::nullopt;
+    std::optional<Mode> mode = std::nullopt;
+    std::optional<std::string> batch = std::nullopt;
+    std::optional<std::string> tune = std::nullopt;  // training set of the tuner
+    int candidates = 32;
+    std::optional<std::string> server = std::nullopt;
+    batch_options bopt { 0, 0, 0, false, "" };
+    checkpoint_options ckpt { "", 600 };
+    std::optional<std::string> coordinator = std::nullopt, worker = std::nullopt;
+    int cube_depth = 0;
+    Policy policy = Policy::Default;
+    bool split = false;  // solves the components apart on -j threads
+    std::optional<std::string> proof_path = std::nullopt;  // DRAT proof, written by the drat policy
     {
         int opt;
-        while ((opt = getopt(argc, argv, "qm:")) != -1) {
+        while ((opt = getopt(argc, argv, "qQ:nsm:o:b:u:j:c:t:f:B:H:A:C:r:R:d:w:e:P:p:kF:O:T:i:")) != -1) {
             switch (opt) {
                 case 'q':
                     queen = true;
                     break;
+                case 'Q':
+                    queens = std::stoi(optarg);
+                    queen = true;
+                    break;
+                case 'n':
+                    print = false;
+                    break;
+                case 's':
+                    stat = true;
+                    break;
+                case 'o':
+                    model_path = optarg;
+                    break;
+                case 'b':
+                    batch = optarg;
+                    break;
+                case 'u':
+                    server = optarg;
+                    break;
+                case 'j':
+                    bopt.threads = std::stoi(optarg);
+                    break;
+                case 'c':
+                    bopt.conflicts = std::stoull(optarg);
+                    break;
+                case 't':
+                    bopt.seconds = std::stod(optarg);
+                    break;
+                case 'B':
+                    cfg.chrono = std::stoi(optarg);
+                    break;
+                case 'd':
+                    coordinator = optarg;
+                    break;
+                case 'w':
+                    worker = optarg;
+                    break;
+                case 'e':
+                    cube_depth = std::stoi(optarg);
+                    break;
+                case 'r':
+                    ckpt.path = optarg;
+                    break;
+                case 'R':
+                    ckpt.seconds = std::stod(optarg);
+                    break;
+                case 'k':
+                    split = true;
+                    break;
+                case 'p':
+                    proof_path = optarg;
+                    break;
+                case 'F':
+                    {
+                        std::ifstream in(optarg);
+                        const int line = (in ? read_config(in, cfg) : -1);
+                        if (line != 0) {
+                            if (line < 0) std::cerr << "cannot read " << optarg << std::endl;
+                            else std::cerr << optarg << ":" << line << ": bad option" << std::endl;
+                            return 1;
+                        }
+                        break;
+                    }
+                case 'T':
+                    tune = optarg;
+                    break;
+                case 'i':
+                    candidates = std::stoi(optarg);
+                    break;
+                case 'O':
+                    if (!set_option(cfg, optarg)) {
+                        std::cerr << "bad option " << optarg << std::endl;
+                        return 1;
+                    }
+                    break;
+                case 'P':
+                    {
+                        std::string s = optarg;
+                        if (s == "default") policy = Policy::Default;
+                        else if (s == "luby") policy = Policy::Luby;
+                        else if (s == "recursive") policy = Policy::Recursive;
+                        else if (s == "keep") policy = Policy::Keep;
+                        else if (s == "drat") policy = Policy::Drat;
+                        else assert(false);
+                        break;
+                    }
+                case 'A':
+                    all = std::stoull(optarg);
+                    break;
+                case 'C':
+                    {
+                        std::string s = optarg;
+                        if (s == "core") core = false;
+                        else if (s == "mus") core = true;
+                        else assert(false);
+                        break;
+                    }
+                case 'H':
+                    {
+                        std::string s = optarg;
+                        if (s == "vsids") cfg.branching.heuristic = Heuristic::VSIDS;
+                        else if (s == "lrb") cfg.branching.heuristic = Heuristic::LRB;
+                        else if (s == "chb") cfg.branching.heuristic = Heuristic::CHB;
+                        else if (s == "switch") cfg.branching.heuristic = Heuristic::Switch;
+                        else assert(false);
+                        break;
+                    }
+                case 'f':
+                    {
+                        std::string s = optarg;
+                        if (s == "json") bopt.json = true;
+                        else if (s == "csv") bopt.json = false;
+                        else assert(false);
+                        break;
+                    }
                 case 'm': 
                     {
                         std::string s = optarg;
-                        if (s == "dpll") dpll = true;
-                        else if (s == "cdcl") dpll = false;
+                        if (s == "dpll") mode = Mode::DPLL;
+                        else if (s == "cdcl") mode = Mode::CDCL;
+                        else if (s == "sls") mode = Mode::SLS;
+                        else if (s == "maxsat") mode = Mode::MaxSAT;
+                        else if (s == "backbone") mode = Mode::Backbone;
                         else assert(false);
                         break;
                     }
@@ -37,41 +414,135 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    auto [ cnf, pn, line ] = parse();
+    if (batch.has_value()) {
+        bopt.output = model_path.value_or("");
+        const auto files = collect_instances(*batch);
+        if (!files.has_value()) {
+            std::cerr << "cannot read " << *batch << std::endl;
+            return 1;
+        }
+        return run_batch(*files, bopt) ? 0 : 1;
+    }
+
+    if (tune.has_value()) {
+        if (bopt.conflicts == 0 && bopt.seconds == 0) {
+            std::cerr << "-T needs a limit per run, -c or -t" << std::endl;
+            return 1;
+        }
+        const auto files = collect_training_set(*tune);
+        if (!files.has_value()) {
+            std::cerr << "cannot read " << *tune << std::endl;
+            return 1;
+        }
+        const tune_options topt { bopt.threads, bopt.conflicts, bopt.seconds, candidates, model_path.value_or("") };
+        return run_tune(*files, cfg, topt) ? 0 : 1;
+    }
+
+    if (worker.has_value()) return work(*worker) ? 0 : 1;
+    if (coordinator.has_value()) {
+        std::ostringstream ss;
+        ss << std::cin.rdbuf();
+        return coordinate(*coordinator, ss.str(), dist_options { bopt.threads, cube_depth, bopt.seconds }, print);
+    }
+
+    if (server.has_value()) {
+        const server_options sopt { bopt.threads, bopt.conflicts, bopt.seconds };
+        if (*server == "-") return serve_stream(STDIN_FILENO, STDOUT_FILENO, sopt) ? 0 : 1;
+        return serve_socket(*server, sopt) ? 0 : 1;
+    }
+
+    // the heuristic of cfg picks the instantiation of every mode on cdcl::Solver
+    const auto heuristic = cfg.branching.heuristic;
+    if (mode == Mode::MaxSAT) {
+        return cdcl::with_heuristic<cdcl::default_policy>(heuristic, [&](auto p) {
+            return maxsat<decltype(p)>(std::cin, print, stat, cfg, bopt.seconds);
+        });
+    }
+
+    auto [ cnf, pn, line ] = (queens != 0 ? std::make_tuple(make_queens(queens), queens * queens, 0) : parse(std::cin));
+    if (cnf == nullptr) {
+        std::cerr << "malformed CNF" << std::endl;
+        return 1;
+    }
+    if ((!cnf->get_cards().empty() || !cnf->get_xors().empty()) && mode != Mode::CDCL && mode != Mode::Backbone) {
+        std::cerr << "cardinality and XOR constraints need -m cdcl or -m backbone" << std::endl;
+        return 1;
+    }
+    if (all.has_value()) {
+        assert(mode == Mode::CDCL);
+        // variables only declared by the header double the models too
+        if (cnf->get_projection().empty()) cnf->declare(pn);
+        Valuation va(cnf->get_pnum());
+        const auto count = cdcl::with_heuristic<cdcl::default_policy>(heuristic, [&](auto p) {
+            return enumerate<decltype(p)>(cnf, &va, print, stat, cfg, *all);
+        });
+        cnf->free();
+        delete cnf;
+        return count != 0 ? 10 : 20;
+    }
+
+    if (mode == Mode::Backbone) {
+        const int ret = cdcl::with_heuristic<cdcl::default_policy>(heuristic, [&](auto p) {
+            return backbone<decltype(p)>(cnf, print, stat, cfg, bopt.seconds);
+        });
+        cnf->free();
+        delete cnf;
+        return ret;
+    }
+
+    if (core.has_value()) {
+        assert(mode == Mode::CDCL);
+        const int ret = solve_core(cnf, pn, print, stat, *core);
+        cnf->free();
+        delete cnf;
+        return ret;
+    }
+
+    if (split && (mode != Mode::CDCL || proof_path.has_value() || !ckpt.path.empty())) {
+        std::cerr << "-k needs -m cdcl and takes no proof or checkpoint" << std::endl;
+        return 1;
+    }
+    std::ofstream proof;
+    if (proof_path.has_value()) {
+        if (!cnf->get_cards().empty() || !cnf->get_xors().empty() || !ckpt.path.empty()) {
+            std::cerr << "proofs need plain CNF and no checkpoint" << std::endl;
+            return 1;
+        }
+        proof.open(*proof_path);
+        policy = Policy::Drat;
+    }
     Valuation va_(cnf->get_pnum());
-    auto res = solve(cnf, &va_, dpll.value());
-    if (res.has_value()) {
+    auto res = split ? solve_split(cnf, &va_, stat, cfg, bopt.threads)
+                     : solve(cnf, &va_, mode.value(), stat, cfg, bopt.seconds, bopt.threads, ckpt, policy,
+                             proof_path.has_value() ? &proof : nullptr);
+    const bool sat = res.has_value();
+    // local search cannot refute a formula
+    const bool unknown = !sat && (mode == Mode::SLS || interrupted);
+
+    OutputBuffer out(sat && print && !model_path ? model_capacity(pn) : 64);
+    if (unknown) print_unknown(out);
+    else print_status(out, sat);
+    if (sat && print) {
         auto va = *res;
-        std::cout << "SAT\n";
         if (queen) {
             int hw = [&] {
                 for (int i = 1;; i++) if (i * i == pn) return i;
             }();
-            std::vector<std::vector<int>> ans(hw, std::vector<int>(hw));
-            for (int i = 0; i < hw; i++) {
-                for (int j = 0; j < hw; j++) {
-                    auto v = int(va->get_value(i * hw + j + 1));
-                    ans[i][j] = (v < 0 ? 0 : 1);
-                    std::cout << v << ' ';
-                }
-                std::cout << std::endl;
+            print_board(out, va, hw);
+        } else if (model_path.has_value()) {
+            OutputBuffer file(model_capacity(pn));
+            print_status(file, sat);
+            print_model(file, va, pn);
+            if (!write_file(*model_path, file)) {
+                std::cerr << "cannot write model to " << *model_path << std::endl;
             }
-            // std::cout << std::boolalpha << check_ans(ans, hw) << std::endl;
         } else {
-            for (int i = 1; i <= pn; i++) {
-                if (va->get_value(i) == PValue::FALSE) std::cout << -i;
-                else if (va->get_value(i) == PValue::TRUE) std::cout << i;
-                else assert(false);
-                std::cout << ' ';
-            }
-            std::cout << std::endl;
+            print_model(out, va, pn);
         }
-        // std::cout << cnf->size() << std::endl;
-    } else {
-        std::cout << "UNSAT\n";
     }
+    out.flush(STDOUT_FILENO);
 
     cnf->free();
     delete cnf;
-    return 0;
+    return sat ? 10 : unknown ? 0 : 20;
 }
@@ -0,0 +1,258 @@
+#include "maxsat.hpp"
+#include <algorithm>
+#include <chrono>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+template <typename Policy>
+MaxSAT<Policy>::MaxSAT(CNF *cnf_, Valuation *va_, std::vector<SoftClause> &&soft_)
+    : cnf(cnf_),
+      va(va_),
+      soft(std::move(soft_)),
+      solver(cnf_, va_),
+      log(nullptr),
+      pnum(cnf_->get_pnum()),
+      budget { 0, 0 },
+      lower(0),
+      ncores(0),
+      upper(std::nullopt),
+      optimal(false),
+      best(pnum + 1, PValue::BOTTOM)
+{
+    weight.assign(2 * (pnum + 1), 0);
+    sum_of.assign(2 * (pnum + 1), -1);
+    for (auto &s : soft) {
+        if (s.lits.empty()) {
+            lower += s.weight;
+            continue;
+        }
+        // a unit soft clause is its own assumption; the others are relaxed by b with b -> clause
+        Literal p = s.lits[0];
+        if (s.lits.size() != 1) {
+            p = make_lit(solver.new_var(), false);
+            auto c = s.lits;
+            c.push_back(~p);
+            solver.add_clause(c);
+        }
+        add_assumption(p, s.weight);
+    }
+}
+
+template <typename Policy>
+MaxSAT<Policy>::~MaxSAT() {
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::set_limits(const cdcl::limits &l) {
+    budget = l;
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::set_branching(const branch_options &opt) {
+    solver.set_branching(opt);
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::set_params(const cdcl::params &p) {
+    solver.set_params(p);
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::set_log(std::ostream *os) {
+    log = os;
+}
+
+template <typename Policy>
+std::uint64_t MaxSAT<Policy>::get_lower() const {
+    return lower;
+}
+
+template <typename Policy>
+std::optional<std::uint64_t> MaxSAT<Policy>::get_upper() const {
+    return upper;
+}
+
+template <typename Policy>
+bool MaxSAT<Policy>::is_optimal() const {
+    return optimal;
+}
+
+template <typename Policy>
+std::uint64_t MaxSAT<Policy>::cores() const {
+    return ncores;
+}
+
+template <typename Policy>
+std::uint64_t& MaxSAT<Policy>::weight_of(const Literal p) {
+    if (int(weight.size()) <= index(p)) {
+        const std::size_t n = 2 * (cnf->get_pnum() + 1);
+        weight.resize(n, 0);
+        sum_of.resize(n, -1);
+    }
+    return weight[index(p)];
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::add_assumption(const Literal p, const std::uint64_t w) {
+    auto &x = weight_of(p);
+    if (x == 0) lits.push_back(p);
+    x += w;
+}
+
+// a leaf for every input, joined pairwise
+template <typename Policy>
+int MaxSAT<Policy>::build(const std::vector<Literal> &inputs, const int fst, const int last) {
+    const int id = nodes.size();
+    if (last - fst == 1) {
+        nodes.push_back(node { -1, -1, 1, { inputs[fst] } });
+        return id;
+    }
+    nodes.push_back(node { -1, -1, last - fst, { } });
+    const int mid = (fst + last) / 2;
+    const int l = build(inputs, fst, mid);
+    const int r = build(inputs, mid, last);
+    nodes[id].left = l;
+    nodes[id].right = r;
+    return id;
+}
+
+// creates the outputs of id up to "k inputs are true" with the clauses
+// (a_i & b_j -> o_{i+j}) of the sums which had no output yet
+template <typename Policy>
+void MaxSAT<Policy>::extend(const int id, int k) {
+    k = std::min(k, nodes[id].size);
+    const int old = nodes[id].outs.size();
+    if (k <= old) return;
+    const int l = nodes[id].left, r = nodes[id].right;
+    extend(l, k);
+    extend(r, k);
+    for (int i = old; i < k; i++) nodes[id].outs.push_back(make_lit(solver.new_var(), false));
+
+    const auto &a = nodes[l].outs, &b = nodes[r].outs;
+    const auto &o = nodes[id].outs;
+    raw_clause c;
+    for (int i = 0; i <= int(a.size()); i++) {
+        for (int j = 0; j <= int(b.size()); j++) {
+            if (i + j <= old || k < i + j) continue;
+            c.clear();
+            if (i != 0) c.push_back(~a[i - 1]);
+            if (j != 0) c.push_back(~b[j - 1]);
+            c.push_back(o[i + j - 1]);
+            solver.add_clause(c);
+        }
+    }
+}
+
+// assumes that at most sums[s].bound inputs of the sum are true
+template <typename Policy>
+void MaxSAT<Policy>::assume_sum(const int s) {
+    auto &sm = sums[s];
+    extend(sm.root, sm.bound + 1);
+    const auto &outs = nodes[sm.root].outs;
+    if (int(outs.size()) <= sm.bound) return;
+    const auto p = ~outs[sm.bound];
+    add_assumption(p, sm.weight);
+    sum_of[index(p)] = s;
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::process_core(const std::vector<Literal> &core) {
+    ncores++;
+    std::uint64_t w = weight_of(core[0]);
+    for (auto p : core) w = std::min(w, weight_of(p));
+    lower += w;
+    if (log != nullptr) *log << "c lb " << lower << std::endl;
+
+    std::vector<Literal> violated;
+    for (auto p : core) {
+        weight_of(p) -= w;
+        violated.push_back(~p);
+        // the sum may exceed its bound by one more input
+        if (const int s = sum_of[index(p)]; s != -1) {
+            sum_of[index(p)] = -1;
+            sums[s].bound++;
+            assume_sum(s);
+        }
+    }
+    if (core.size() == 1) {
+        solver.add_clause(violated);
+        return;
+    }
+    sums.push_back(sum { build(violated, 0, violated.size()), 1, w });
+    assume_sum(sums.size() - 1);
+}
+
+template <typename Policy>
+std::uint64_t MaxSAT<Policy>::cost() const {
+    std::uint64_t ret = 0;
+    for (const auto &s : soft) {
+        const bool sat = std::any_of(ALL(s.lits), [&](const Literal p) { return va->get_value(p) == PValue::TRUE; });
+        if (!sat) ret += s.weight;
+    }
+    return ret;
+}
+
+template <typename Policy>
+void MaxSAT<Policy>::improve() {
+    const auto c = cost();
+    if (upper.has_value() && *upper <= c) return;
+    upper = c;
+    for (int i = 1; i <= pnum; i++) best[i] = va->get_value(Var(i));
+    if (log != nullptr) *log << "o " << c << std::endl;
+}
+
+template <typename Policy>
+std::optional<std::uint64_t> MaxSAT<Policy>::solve() {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::uint64_t threshold = 0;
+    for (auto p : lits) threshold = std::max(threshold, weight[index(p)]);
+    std::vector<Literal> assumptions;
+    while (!optimal) {
+        if (budget.seconds != 0) {
+            const std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+            if (budget.seconds <= d.count()) break;
+            solver.set_limits(cdcl::limits { budget.conflicts, budget.seconds - d.count() });
+        } else {
+            solver.set_limits(budget);
+        }
+
+        // assumptions without weight left are dropped for good
+        lits.erase(std::remove_if(ALL(lits), [&](const Literal p) { return weight[index(p)] == 0; }), std::end(lits));
+        assumptions.clear();
+        for (auto p : lits) {
+            if (threshold <= weight[index(p)]) assumptions.push_back(p);
+        }
+
+        const auto res = solver.search(assumptions);
+        if (res == cdcl::Result::Unknown) break;
+        if (res == cdcl::Result::UNSAT) {
+            // nothing to relax: the hard clauses are unsatisfiable
+            if (solver.get_core().empty()) return std::nullopt;
+            process_core(solver.get_core());
+            optimal = (upper.has_value() && *upper <= lower);
+            continue;
+        }
+
+        improve();
+        // every assumption of the next stratum, or none left: the model is optimal
+        std::uint64_t next = 0;
+        for (auto p : lits) {
+            if (weight[index(p)] < threshold) next = std::max(next, weight[index(p)]);
+        }
+        optimal = (next == 0 || *upper <= lower);
+        threshold = next;
+    }
+
+    if (upper.has_value()) {
+        for (int i = 1; i <= pnum; i++) va->assign(Var(i), best[i], 0);
+    }
+    if (!optimal) return std::nullopt;
+    return upper;
+}
+
+// default_policy with every branching policy, which main picks by cdcl::with_heuristic
+template struct MaxSAT<cdcl::with_branch<cdcl::default_policy, VSIDSBranch>>;
+template struct MaxSAT<cdcl::with_branch<cdcl::default_policy, LRBBranch>>;
+template struct MaxSAT<cdcl::with_branch<cdcl::default_policy, CHBBranch>>;
+template struct MaxSAT<cdcl::with_branch<cdcl::default_policy, SwitchBranch>>;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include "../cnf.hpp"
+#include "../cdcl/cdcl.hpp"
+
+// Weighted MaxSAT by core-guided search with OLL (Andres et al., 2012; Morgado et al., 2014),
+// in the style of RC2 (Ignatiev et al., 2019), over a single incremental CDCL instance.
+// Every soft clause gets an assumption literal which is true when it is satisfied. A core
+// (assumptions which cannot hold together) raises the lower bound by its minimum weight w,
+// takes w off each of its literals, and adds a totalizer over their violations whose
+// "at most 1 violated" output becomes a new assumption of weight w; a core containing
+// such an output moves it to "at most 2" and so on. Assumptions are stratified by weight:
+// the heavy ones are tried first and every model found on the way is an upper bound.
+// The CDCL instance is a cdcl::Solver<Policy>, built for default_policy with each heuristic.
+template <typename Policy>
+struct MaxSAT {
+    MaxSAT() = delete;
+    // cnf holds the hard clauses; va receives an optimal model
+    MaxSAT(CNF *cnf_, Valuation *va_, std::vector<SoftClause> &&soft_);
+    ~MaxSAT();
+
+    // the optimum cost, or nullopt if the hard clauses are unsatisfiable
+    // or the limits ran out before any model (see get_upper())
+    std::optional<std::uint64_t> solve();
+    void set_limits(const cdcl::limits &l);
+    void set_branching(const branch_options &opt);
+    void set_params(const cdcl::params &p);
+    // "o <cost>" for every better model and "c lb <cost>" for every better lower bound
+    void set_log(std::ostream *os);
+
+    std::uint64_t get_lower() const;
+    std::optional<std::uint64_t> get_upper() const;  // cost of the best model found
+    bool is_optimal() const;
+    std::uint64_t cores() const;
+
+private:
+    // outs[i] is implied once i + 1 of the inputs under the node are true
+    struct node {
+        int left, right;  // -1 for a leaf
+        int size;
+        std::vector<Literal> outs;
+    };
+    struct sum {
+        int root;
+        int bound;            // the assumption says fewer than bound inputs are true
+        std::uint64_t weight;
+    };
+
+    CNF *cnf;
+    Valuation *va;
+    std::vector<SoftClause> soft;
+    cdcl::Solver<Policy> solver;
+    std::ostream *log;
+    int pnum;  // variables of the input; relaxation and totalizer variables follow them
+    cdcl::limits budget;
+
+    std::uint64_t lower, ncores;
+    std::optional<std::uint64_t> upper;
+    bool optimal;
+    std::vector<PValue> best;  // values of the original variables in the best model
+
+    std::vector<Literal> lits;         // assumptions, including those of weight 0 until the next cleanup
+    std::vector<std::uint64_t> weight;  // by literal index
+    std::vector<int> sum_of;            // by literal index: the sum whose output it negates, or -1
+    std::vector<node> nodes;
+    std::vector<sum> sums;
+
+    void add_assumption(const Literal p, const std::uint64_t w);
+    std::uint64_t& weight_of(const Literal p);
+    int build(const std::vector<Literal> &inputs, int fst, int last);
+    void extend(const int id, const int k);
+    void assume_sum(const int s);
+    void process_core(const std::vector<Literal> &core);
+    std::uint64_t cost() const;
+    void improve();
+};
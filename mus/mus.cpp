@@ -0,0 +1,98 @@
+#include "mus.hpp"
+#include <algorithm>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+namespace {
+
+std::vector<raw_clause> selected(CNF *cnf) {
+    std::vector<raw_clause> ret(cnf->size());
+    const int pnum = cnf->get_pnum();
+    for (int i = 0; i < cnf->size(); i++) {
+        ret[i] = cnf->get(i)->raw();
+        ret[i].push_back(make_lit(Var(pnum + 1 + i), true));
+    }
+    return ret;
+}
+
+}
+
+MUS::MUS(CNF *cnf_)
+    : pnum(cnf_->get_pnum()),
+      sel(selected(cnf_), std::vector<AtMost>(cnf_->get_cards()), std::vector<raw_clause>(cnf_->get_xors())),
+      va(pnum + cnf_->size()),
+      solver(&sel, &va),
+      nchecks(0)
+{
+    sel.declare(pnum + cnf_->size());
+}
+
+MUS::~MUS() {
+    sel.free();
+}
+
+Literal MUS::selector(const int i) const {
+    return make_lit(Var(pnum + 1 + i), false);
+}
+
+int MUS::clause_of(const Literal s) const {
+    return index(var(s)) - pnum - 1;
+}
+
+cdcl::Result MUS::solve() {
+    std::vector<Literal> assumptions(sel.size());
+    for (int i = 0; i < int(assumptions.size()); i++) assumptions[i] = selector(i);
+    const auto res = solver.search(assumptions);
+    if (res == cdcl::Result::UNSAT) core = solver.get_core();
+    return res;
+}
+
+void MUS::minimize() {
+    // core = crit + rest: crit is known to be necessary, rest is yet to be checked
+    std::vector<Literal> crit, rest = core, assumptions;
+    std::vector<char> in_core(sel.size(), 0);
+    while (!rest.empty()) {
+        const auto p = rest.back();
+        rest.pop_back();
+        assumptions = crit;
+        assumptions.insert(std::end(assumptions), ALL(rest));
+        nchecks++;
+        const auto res = solver.search(assumptions);
+        if (res == cdcl::Result::UNSAT) {
+            // p is never needed again, and the candidates shrink to the new core
+            solver.add_clause(raw_clause { ~p });
+            const auto &c = solver.get_core();
+            for (auto q : c) in_core[clause_of(q)] = 1;
+            rest.erase(std::remove_if(ALL(rest), [&](const Literal q) { return !in_core[clause_of(q)]; }), std::end(rest));
+            for (auto q : c) in_core[clause_of(q)] = 0;
+            continue;
+        }
+        // satisfiable without p, so every core of the rest contains p
+        crit.push_back(p);
+        solver.add_clause(raw_clause { p });
+    }
+    core = std::move(crit);
+}
+
+std::vector<int> MUS::get_core() const {
+    std::vector<int> ret;
+    for (auto p : core) ret.push_back(clause_of(p));
+    std::sort(ALL(ret));
+    return ret;
+}
+
+const Valuation* MUS::get_model() const {
+    return &va;
+}
+
+void MUS::set_limits(const cdcl::limits &l) {
+    solver.set_limits(l);
+}
+
+const cdcl::statistics& MUS::get_statistics() const {
+    return solver.get_statistics();
+}
+
+int MUS::checks() const {
+    return nchecks;
+}
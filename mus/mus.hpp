@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include "../cnf.hpp"
+#include "../cdcl/cdcl.hpp"
+
+// Unsatisfiable cores in terms of the clauses of a CNF. Clause i is solved as
+// (clause_i | ~s_i) under the assumption s_i, so the core of the assumptions names
+// the clauses a refutation needed. Cardinality and XOR constraints are kept
+// unconditional and never appear in a core.
+// minimize() shrinks a core to a minimal one by deletion (Marques-Silva, 2010) on the
+// same incremental solver: every clause is dropped in turn, and the core of each
+// unsatisfiable check replaces the rest of the candidates (clause set refinement).
+struct MUS {
+    MUS() = delete;
+    MUS(CNF *cnf_);
+    ~MUS();
+
+    // SAT, UNSAT, or Unknown when the limits are exhausted
+    cdcl::Result solve();
+    // after UNSAT: removing any clause of the core makes it satisfiable; a check which
+    // runs out of the limits keeps its clause
+    void minimize();
+    // indices of clauses of cnf_ which are unsatisfiable together, sorted
+    std::vector<int> get_core() const;
+    const Valuation* get_model() const;  // after SAT
+    void set_limits(const cdcl::limits &l);
+    const cdcl::statistics& get_statistics() const;
+    int checks() const;  // searches made by minimize()
+
+private:
+    int pnum;  // variables of cnf_; the selector of clause i is pnum + 1 + i
+    CNF sel;
+    Valuation va;
+    cdcl::CDCL solver;
+    std::vector<Literal> core;
+    int nchecks;
+
+    Literal selector(const int i) const;
+    int clause_of(const Literal s) const;
+};
@@ -0,0 +1,190 @@
+#include "output.hpp"
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int line_width = 78;
+
+constexpr char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// writes the decimal digits of x backwards, ending at last
+char* format_uint(std::uint32_t x, char *last) {
+    while (100 <= x) {
+        const auto r = (x % 100) * 2;
+        x /= 100;
+        *--last = digit_pairs[r + 1];
+        *--last = digit_pairs[r];
+    }
+    if (10 <= x) {
+        *--last = digit_pairs[x * 2 + 1];
+        *--last = digit_pairs[x * 2];
+    } else {
+        *--last = char('0' + x);
+    }
+    return last;
+}
+
+int count_digits(int x) {
+    int ret = 1;
+    while (10 <= x) {
+        x /= 10;
+        ret++;
+    }
+    return ret;
+}
+
+}
+
+
+/* ========== OutputBuffer ========== */
+
+OutputBuffer::OutputBuffer(const std::size_t capacity)
+    : buf(capacity), pos(0)
+{
+}
+
+void OutputBuffer::reserve(const std::size_t n) {
+    if (pos + n <= buf.size()) return;
+    buf.resize(std::max(buf.size() * 2, pos + n));
+}
+
+void OutputBuffer::put(const char c) {
+    reserve(1);
+    buf[pos++] = c;
+}
+
+void OutputBuffer::put(const char *s) {
+    const auto n = std::strlen(s);
+    reserve(n);
+    std::memcpy(buf.data() + pos, s, n);
+    pos += n;
+}
+
+void OutputBuffer::put_int(const int x) {
+    char tmp[16];
+    char *last = tmp + sizeof(tmp);
+    const auto u = (x < 0 ? -std::uint32_t(x) : std::uint32_t(x));
+    char *fst = format_uint(u, last);
+    if (x < 0) *--fst = '-';
+    const auto n = std::size_t(last - fst);
+    reserve(n);
+    std::memcpy(buf.data() + pos, fst, n);
+    pos += n;
+}
+
+std::size_t OutputBuffer::size() const {
+    return pos;
+}
+
+void OutputBuffer::clear() {
+    pos = 0;
+}
+
+bool OutputBuffer::flush(const int fd) {
+    std::size_t done = 0;
+    while (done < pos) {
+        const auto n = ::write(fd, buf.data() + done, pos - done);
+        if (n < 0) return false;
+        done += n;
+    }
+    pos = 0;
+    return true;
+}
+
+
+/* ========== printer ========== */
+
+void print_status(OutputBuffer &out, const bool sat) {
+    out.put(sat ? "s SATISFIABLE\n" : "s UNSATISFIABLE\n");
+}
+
+void print_unknown(OutputBuffer &out) {
+    out.put("s UNKNOWN\n");
+}
+
+namespace {
+
+// appends p to the "v" lines
+void put_item(OutputBuffer &out, const int p, int &width) {
+    const int len = count_digits(p < 0 ? -p : p) + (p < 0) + 1;
+    if (width == 0) {
+        out.put('v');
+        width = 1;
+    } else if (line_width < width + len) {
+        out.put("\nv");
+        width = 1;
+    }
+    out.put(' ');
+    out.put_int(p);
+    width += len;
+}
+
+// appends the value of variable i to the "v" lines
+void put_value(OutputBuffer &out, const Valuation *va, const int i, int &width) {
+    // variables declared in the header but absent from every clause are free
+    const auto v = (i <= va->get_pnum() ? va->get_value(Var(i)) : PValue::FALSE);
+    assert(v != PValue::BOTTOM);
+    put_item(out, v == PValue::FALSE ? -i : i, width);
+}
+
+}
+
+void print_model(OutputBuffer &out, const Valuation *va, const int pnum) {
+    int width = 0;
+    for (int i = 1; i <= pnum; i++) put_value(out, va, i, width);
+    out.put(width == 0 ? "v 0\n" : " 0\n");
+}
+
+void print_model(OutputBuffer &out, const Valuation *va, const std::vector<Var> &vars) {
+    int width = 0;
+    for (auto v : vars) put_value(out, va, index(v), width);
+    out.put(width == 0 ? "v 0\n" : " 0\n");
+}
+
+void print_core(OutputBuffer &out, const std::vector<int> &clauses) {
+    int width = 0;
+    for (auto i : clauses) put_item(out, i + 1, width);
+    out.put(width == 0 ? "v 0\n" : " 0\n");
+}
+
+void print_literals(OutputBuffer &out, const std::vector<Literal> &lits) {
+    int width = 0;
+    for (auto p : lits) put_item(out, to_dimacs(p), width);
+    out.put(width == 0 ? "v 0\n" : " 0\n");
+}
+
+void print_board(OutputBuffer &out, const Valuation *va, const int hw) {
+    for (int i = 0; i < hw; i++) {
+        for (int j = 0; j < hw; j++) {
+            out.put_int(int(va->get_value(Var(i * hw + j + 1))));
+            out.put(' ');
+        }
+        out.put('\n');
+    }
+}
+
+std::size_t model_capacity(const int pnum) {
+    // "-<digits> " per variable and "v " / "\n" per line
+    const std::size_t per_var = count_digits(pnum) + 2;
+    return 64 + std::size_t(pnum) * per_var * 41 / 40;
+}
+
+bool write_file(const std::string &path, OutputBuffer &out) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const bool ok = out.flush(fd);
+    return ::close(fd) == 0 && ok;
+}
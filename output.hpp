@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <optional>
+#include "cnf.hpp"
+
+// Collects the whole answer in memory so that it can be handed to the kernel
+// with a single write(2) instead of one stream operation per literal.
+struct OutputBuffer {
+    OutputBuffer() = delete;
+    OutputBuffer(const std::size_t capacity);
+
+    void put(const char c);
+    void put(const char *s);
+    void put_int(const int x);
+    std::size_t size() const;
+    void clear();  // drops what has not been flushed
+    bool flush(const int fd);
+
+private:
+    std::vector<char> buf;
+    std::size_t pos;
+
+    void reserve(const std::size_t n);
+};
+
+// SAT competition format: "s SATISFIABLE" followed by "v ... 0" lines.
+void print_status(OutputBuffer &out, const bool sat);
+void print_unknown(OutputBuffer &out);
+void print_model(OutputBuffer &out, const Valuation *va, const int pnum);
+void print_model(OutputBuffer &out, const Valuation *va, const std::vector<Var> &vars);  // only vars
+// MUS competition format: the 1-based indices of the clauses of an unsatisfiable core as "v ... 0"
+void print_core(OutputBuffer &out, const std::vector<int> &clauses);
+// literals such as a backbone as "v ... 0"
+void print_literals(OutputBuffer &out, const std::vector<Literal> &lits);
+void print_board(OutputBuffer &out, const Valuation *va, const int hw);
+
+std::size_t model_capacity(const int pnum);
+bool write_file(const std::string &path, OutputBuffer &out);
@@ -0,0 +1,131 @@
+#include "perf.hpp"
+
+#ifdef PERF_STATS
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace perf {
+
+namespace {
+
+constexpr std::uint64_t configs[event_num] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+const char *phase_names[phase_num] = { "propagate", "analyze", "backtrack", "decide", "reduce", "other" };
+
+int open_event(const std::uint64_t config, const int group) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+}
+
+Counters::Counters()
+    : cur(Phase::Other), last { }, total { }, window { }
+{
+    for (int i = 0; i < event_num; i++) {
+        fd[i] = open_event(configs[i], i == 0 ? -1 : fd[0]);
+        if (fd[i] != -1) continue;
+        error = std::strerror(errno);
+        for (int j = 0; j < i; j++) ::close(fd[j]);
+        fd[0] = -1;
+        return;
+    }
+    ioctl(fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    read(last);
+}
+
+Counters::~Counters() {
+    if (!available()) return;
+    for (int i = 0; i < event_num; i++) ::close(fd[i]);
+}
+
+bool Counters::available() const {
+    return fd[0] != -1;
+}
+
+// a single read(2) of the whole group: { nr, ev[0], ..., ev[nr - 1] }
+void Counters::read(counts &c) const {
+    std::uint64_t buf[1 + event_num];
+    if (::read(fd[0], buf, sizeof(buf)) != sizeof(buf)) return;
+    std::memcpy(c.ev, buf + 1, sizeof(c.ev));
+}
+
+void Counters::charge() {
+    counts now;
+    read(now);
+    for (int i = 0; i < event_num; i++) {
+        const auto d = now.ev[i] - last.ev[i];
+        total[int(cur)].ev[i] += d;
+        window[int(cur)].ev[i] += d;
+    }
+    last = now;
+}
+
+Phase Counters::switch_to(const Phase p) {
+    const auto prev = cur;
+    if (!available() || p == cur) return prev;
+    charge();
+    cur = p;
+    return prev;
+}
+
+// one line per phase: share of the cycles, IPC, cache and branch misses per 1000 instructions
+void Counters::print(std::ostream &os, const char *label, const counts *per_phase) {
+    std::uint64_t cycles = 0;
+    for (int p = 0; p < phase_num; p++) cycles += per_phase[p].ev[0];
+    const auto flags = os.flags();
+    os << std::fixed << std::setprecision(2);
+    for (int p = 0; p < phase_num; p++) {
+        const auto &c = per_phase[p];
+        const double ins = std::max<std::uint64_t>(c.ev[1], 1);
+        os << "c perf " << label << ' ' << std::left << std::setw(9) << phase_names[p] << std::right
+           << " cycles " << std::setw(14) << c.ev[0]
+           << " (" << std::setw(5) << 100.0 * c.ev[0] / std::max<std::uint64_t>(cycles, 1) << "%)"
+           << "  ipc " << std::setw(5) << (c.ev[0] == 0 ? 0.0 : c.ev[1] / double(c.ev[0]))
+           << "  cache-miss/ki " << std::setw(7) << 1000 * c.ev[2] / ins
+           << "  branch-miss/ki " << std::setw(7) << 1000 * c.ev[3] / ins << '\n';
+    }
+    os.flags(flags);
+}
+
+void Counters::report(std::ostream &os, const std::uint64_t conflicts) {
+    if (!available()) return;
+    charge();
+    const auto label = "@" + std::to_string(conflicts);
+    print(os, label.c_str(), window);
+    for (auto &c : window) c = counts { };
+}
+
+void Counters::summary(std::ostream &os) {
+    if (!available()) {
+        os << "c perf counters unavailable: " << error << '\n';
+        return;
+    }
+    charge();
+    print(os, "total", total);
+}
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Hardware event counts (perf_event_open(2)) attributed to the phases of the CDCL loop.
+// Compiled in only with -DPERF_STATS; otherwise Counters and Scope are empty and every
+// call compiles to nothing.
+namespace perf {
+
+enum class Phase {
+    Propagate,
+    Analyze,
+    Backtrack,
+    Decide,
+    Reduce,
+    Other,
+};
+
+constexpr int phase_num = 6;
+constexpr int event_num = 4;  // cycles, instructions, cache misses, branch misses
+
+struct counts {
+    std::uint64_t ev[event_num];
+};
+
+#ifdef PERF_STATS
+
+// One counter group of the calling thread, so a solver has to stay on one thread.
+struct Counters {
+    Counters();
+    ~Counters();
+    Counters(const Counters&) = delete;
+    Counters& operator=(const Counters&) = delete;
+
+    bool available() const;
+    // charges the events since the last switch to the current phase, returns it
+    Phase switch_to(const Phase p);
+    // the counts per phase since the previous report
+    void report(std::ostream &os, const std::uint64_t conflicts);
+    void summary(std::ostream &os);
+
+private:
+    int fd[event_num];
+    std::string error;  // why the counters could not be opened
+    Phase cur;
+    counts last;
+    counts total[phase_num], window[phase_num];
+
+    void read(counts &c) const;
+    void charge();  // adds the events since the last read to the current phase
+    static void print(std::ostream &os, const char *label, const counts *per_phase);
+};
+
+// attributes the events of its lifetime to p
+struct Scope {
+    Scope(Counters &c_, const Phase p) : c(c_), prev(c.switch_to(p)) { }
+    ~Scope() { c.switch_to(prev); }
+
+private:
+    Counters &c;
+    const Phase prev;
+};
+
+#else
+
+struct Counters {
+    bool available() const { return false; }
+    void report(std::ostream&, const std::uint64_t) { }
+    void summary(std::ostream&) { }
+};
+
+struct Scope {
+    Scope(Counters&, const Phase) { }
+};
+
+#endif
+
+}
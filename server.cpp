@@ -0,0 +1,302 @@
+#include "server.hpp"
+#include "util.hpp"
+#include "output.hpp"
+#include "cdcl/cdcl.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// larger payloads are refused before anything is allocated for them
+constexpr std::size_t max_frame = std::size_t(1) << 30;
+
+/* ========== FrameReader ========== */
+
+// buffered reads of header lines and payloads from a file descriptor
+struct FrameReader {
+    FrameReader() = delete;
+    FrameReader(const int fd_)
+        : fd(fd_), buf(1 << 16), b(0), e(0)
+    {
+    }
+
+    // a line longer than max_line is cut there, which no header is
+    bool read_line(std::string &s) {
+        s.clear();
+        while (true) {
+            if (max_line <= s.size()) return true;
+            if (b == e && !fill()) return !s.empty();
+            const auto nl = std::find(buf.data() + b, buf.data() + e, '\n');
+            s.append(buf.data() + b, nl);
+            b = nl - buf.data();
+            if (b != e) {
+                b++;
+                return true;
+            }
+        }
+    }
+
+    bool read_exact(std::string &s, std::size_t n) {
+        s.resize(n);
+        std::size_t done = 0;
+        while (done < n) {
+            if (b == e && !fill()) return false;
+            const auto k = std::min(n - done, e - b);
+            std::memcpy(&s[done], buf.data() + b, k);
+            b += k;
+            done += k;
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::size_t max_line = 1 << 12;
+
+    const int fd;
+    std::vector<char> buf;
+    std::size_t b, e;
+
+    bool fill() {
+        const auto n = ::read(fd, buf.data(), buf.size());
+        if (n <= 0) return false;
+        b = 0;
+        e = n;
+        return true;
+    }
+};
+
+
+/* ========== WorkerPool ========== */
+
+struct request {
+    bool binary;
+    const std::string *payload;
+    cdcl::limits lim;
+    int out_fd;
+};
+
+// buffers owned by one worker and reused by every request it solves
+struct workspace {
+    std::vector<raw_clause> clauses;
+    OutputBuffer head, body;
+
+    workspace() : head(32), body(1 << 16) { }
+};
+
+void answer(workspace &ws, const request &req) {
+    ws.clauses.clear();
+    int pn = 0;
+    const char *fst = req.payload->data(), *last = fst + req.payload->size();
+    const bool ok = (req.binary ? parse_binary(fst, last, pn, ws.clauses) : parse_buffer(fst, last, pn, ws.clauses));
+    if (!ok) {
+        ws.body.put("e malformed CNF\n");
+        return;
+    }
+    CNF cnf(std::move(ws.clauses));
+    Valuation va(cnf.get_pnum());
+    cdcl::Result res;
+    try {
+        cdcl::CDCL solver(&cnf, &va);
+        solver.set_limits(req.lim);
+        res = solver.search();
+    } catch (...) {
+        cnf.free();
+        throw;
+    }
+    if (res == cdcl::Result::Unknown) {
+        print_unknown(ws.body);
+    } else {
+        print_status(ws.body, res == cdcl::Result::SAT);
+        if (res == cdcl::Result::SAT) print_model(ws.body, &va, pn);
+    }
+    cnf.free();
+}
+
+void respond(workspace &ws, const request &req) {
+    try {
+        answer(ws, req);
+    } catch (const std::exception &e) {
+        // an instance too large for the memory fails its own request, not the daemon
+        ws.clauses = std::vector<raw_clause>();
+        ws.body.clear();
+        ws.body.put("e ");
+        ws.body.put(e.what());
+        ws.body.put('\n');
+    }
+    ws.head.put_int(ws.body.size());
+    ws.head.put('\n');
+    ws.head.flush(req.out_fd);
+    ws.body.flush(req.out_fd);
+}
+
+struct WorkerPool {
+    WorkerPool() = delete;
+    WorkerPool(int threads)
+        : stop(false)
+    {
+        if (threads == 0) threads = std::max(1, int(std::thread::hardware_concurrency()));
+        for (int t = 0; t < threads; t++) pool.emplace_back([this] { run(); });
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto &t : pool) t.join();
+    }
+
+    // blocks until the response of req has been written
+    void solve(const request &req) {
+        job j { &req, false };
+        std::unique_lock<std::mutex> lock(mtx);
+        que.push_back(&j);
+        cv.notify_one();
+        done_cv.wait(lock, [&] { return j.done; });
+    }
+
+private:
+    struct job {
+        const request *req;
+        bool done;
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv, done_cv;
+    std::deque<job*> que;
+    std::vector<std::thread> pool;
+    bool stop;
+
+    void run() {
+        workspace ws;
+        while (true) {
+            job *j;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return stop || !que.empty(); });
+                if (que.empty()) return;
+                j = que.front();
+                que.pop_front();
+            }
+            respond(ws, *j->req);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                j->done = true;
+            }
+            done_cv.notify_all();
+        }
+    }
+};
+
+
+/* ========== connection ========== */
+
+bool write_error(const int fd, const char *msg) {
+    OutputBuffer out(64);
+    out.put_int(std::strlen(msg) + 3);
+    out.put("\ne ");
+    out.put(msg);
+    out.put('\n');
+    return out.flush(fd);
+}
+
+void read_requests(const int in_fd, const int out_fd, WorkerPool &pool, const server_options &opt) {
+    FrameReader reader(in_fd);
+    std::string line, payload;
+    while (reader.read_line(line)) {
+        if (line.empty()) continue;
+        std::istringstream ss(line);
+        std::string format;
+        std::size_t bytes = 0;
+        request req { false, &payload, cdcl::limits { opt.conflicts, opt.seconds }, out_fd };
+        ss >> format >> bytes;
+        if (!ss || (format != "dimacs" && format != "binary")) {
+            write_error(out_fd, "bad request header");
+            return;
+        }
+        if (max_frame < bytes) {
+            write_error(out_fd, "frame too large");
+            return;
+        }
+        req.binary = (format == "binary");
+        if (ss >> req.lim.conflicts) ss >> req.lim.seconds;
+        if (!reader.read_exact(payload, bytes)) return;
+        pool.solve(req);
+    }
+}
+
+void serve_connection(const int in_fd, const int out_fd, WorkerPool &pool, const server_options &opt) {
+    try {
+        read_requests(in_fd, out_fd, pool, opt);
+    } catch (const std::exception &e) {
+        write_error(out_fd, e.what());
+    }
+}
+
+const char *socket_path = nullptr;
+
+void remove_socket(int sig) {
+    if (socket_path != nullptr) ::unlink(socket_path);
+    std::_Exit(128 + sig);
+}
+
+}
+
+bool serve_stream(const int in_fd, const int out_fd, const server_options &opt) {
+    std::signal(SIGPIPE, SIG_IGN);
+    // requests of a single stream are answered one at a time
+    WorkerPool pool(1);
+    serve_connection(in_fd, out_fd, pool, opt);
+    return true;
+}
+
+bool serve_socket(const std::string &path, const server_options &opt) {
+    sockaddr_un addr { };
+    addr.sun_family = AF_UNIX;
+    if (sizeof(addr.sun_path) <= path.size()) return false;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 64) < 0) {
+        ::close(fd);
+        return false;
+    }
+    socket_path = addr.sun_path;
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, remove_socket);
+    std::signal(SIGTERM, remove_socket);
+
+    WorkerPool pool(opt.threads);
+    while (true) {
+        const int conn = ::accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        std::thread([conn, &pool, &opt] {
+            serve_connection(conn, conn, pool, opt);
+            ::close(conn);
+        }).detach();
+    }
+    ::close(fd);
+    ::unlink(path.c_str());
+    socket_path = nullptr;
+    return false;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+struct server_options {
+    int threads;               // solver workers, 0 picks the hardware concurrency
+    std::uint64_t conflicts;   // default limit of a request, 0 means no limit
+    double seconds;            // default limit of a request, 0 means no limit
+};
+
+// Framed protocol, one request at a time per connection:
+//   request  : "<dimacs|binary> <bytes> [conflicts [seconds]]\n" followed by <bytes> of payload
+//   response : "<bytes>\n" followed by "s ..." and "v ... 0" lines, or "e <message>\n"
+// A binary payload is the format read by parse_binary() (see util.hpp). A header of more
+// than 1 GiB of payload is answered with an error and closes the connection.
+// Each worker keeps its parse and output buffers across requests.
+
+// Accepts connections on a Unix domain socket until the process is terminated.
+bool serve_socket(const std::string &path, const server_options &opt);
+// Serves the single framed stream of in_fd / out_fd until end of input.
+bool serve_stream(const int in_fd, const int out_fd, const server_options &opt);
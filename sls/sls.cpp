@@ -0,0 +1,189 @@
+#include "sls.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#define ALL(V) std::begin(V), std::end(V)
+
+namespace {
+
+// cb of the polynomial break function, tuned for 3-SAT
+constexpr double cb = 2.3;
+constexpr int max_break = 64;
+
+}
+
+SLS::SLS(CNF *cnf, const int clauses_)
+    : pnum(cnf->get_pnum()),
+      m(clauses_),
+      occ_start(2 * (pnum + 1) + 1, 0),
+      value(pnum + 1, 0),
+      fixed(pnum + 1, 0),
+      best(pnum + 1, 0),
+      true_count(m),
+      critical(m),
+      break_count(pnum + 1),
+      where(m),
+      prob(max_break + 1),
+      best_unsat(0),
+      rng(42)
+{
+    start.reserve(m + 1);
+    int longest = 0;
+    for (int i = 0; i < m; i++) {
+        const auto c = cnf->get(i);
+        longest = std::max(longest, c->size());
+        start.push_back(lits.size());
+        for (int k = 0; k < c->size(); k++) {
+            lits.push_back(c->get(k));
+            occ_start[index(c->get(k)) + 1]++;
+        }
+    }
+    start.push_back(lits.size());
+
+    for (int i = 1; i < int(occ_start.size()); i++) occ_start[i] += occ_start[i - 1];
+    occ.resize(lits.size());
+    std::vector<int> pos(std::begin(occ_start), std::end(occ_start) - 1);
+    for (int c = 0; c < m; c++) {
+        for (int k = start[c]; k < start[c + 1]; k++) occ[pos[index(lits[k])]++] = c;
+    }
+
+    for (int b = 0; b <= max_break; b++) prob[b] = std::pow(1.0 + b, -cb);
+    unsat.reserve(m);
+    weight.reserve(longest);
+}
+
+bool SLS::is_true(const Literal p) const {
+    return value[index(var(p))] != is_neg(p);
+}
+
+// rebuilds every cache from value
+void SLS::init() {
+    std::fill(ALL(break_count), 0);
+    unsat.clear();
+    for (int c = 0; c < m; c++) {
+        int cnt = 0, x = 0;
+        for (int k = start[c]; k < start[c + 1]; k++) {
+            if (!is_true(lits[k])) continue;
+            cnt++;
+            x ^= index(var(lits[k]));
+        }
+        true_count[c] = cnt;
+        critical[c] = x;
+        if (cnt == 0) {
+            where[c] = unsat.size();
+            unsat.push_back(c);
+        } else if (cnt == 1) {
+            break_count[x]++;
+        }
+    }
+    best = value;
+    best_unsat = unsat.size();
+}
+
+void SLS::flip(const int x) {
+    value[x] ^= 1;
+    const auto t = make_lit(Var(x), !value[x]);  // the literal which became true
+
+    for (int i = occ_start[index(t)]; i < occ_start[index(t) + 1]; i++) {
+        const int c = occ[i];
+        const int cnt = true_count[c]++;
+        if (cnt == 0) {
+            const int last = unsat.back();
+            unsat[where[c]] = last;
+            where[last] = where[c];
+            unsat.pop_back();
+            break_count[x]++;
+        } else if (cnt == 1) {
+            break_count[critical[c]]--;
+        }
+        critical[c] ^= x;
+    }
+
+    const auto f = ~t;
+    for (int i = occ_start[index(f)]; i < occ_start[index(f) + 1]; i++) {
+        const int c = occ[i];
+        const int cnt = --true_count[c];
+        critical[c] ^= x;
+        if (cnt == 0) {
+            where[c] = unsat.size();
+            unsat.push_back(c);
+            break_count[x]--;
+        } else if (cnt == 1) {
+            break_count[critical[c]]++;
+        }
+    }
+}
+
+// the variable of clause c to flip, or 0 if all of them are fixed
+int SLS::pick(const int c) {
+    weight.clear();
+    double sum = 0;
+    for (int k = start[c]; k < start[c + 1]; k++) {
+        const int x = index(var(lits[k]));
+        const double w = (fixed[x] ? 0 : prob[std::min(break_count[x], max_break)]);
+        weight.push_back(w);
+        sum += w;
+    }
+    if (sum == 0) return 0;
+    double r = std::uniform_real_distribution<double>(0, sum)(rng);
+    for (int k = start[c]; k < start[c + 1]; k++) {
+        r -= weight[k - start[c]];
+        if (r <= 0 && weight[k - start[c]] != 0) return index(var(lits[k]));
+    }
+    for (int k = start[c + 1] - 1; start[c] <= k; k--) {
+        if (weight[k - start[c]] != 0) return index(var(lits[k]));
+    }
+    return 0;
+}
+
+// flips until every clause is satisfied or max_flips; returns the flips done
+std::uint64_t SLS::run(const std::uint64_t max_flips) {
+    std::uint64_t flips = 0;
+    while (!unsat.empty() && flips < max_flips) {
+        const int c = unsat[std::uniform_int_distribution<int>(0, unsat.size() - 1)(rng)];
+        const int x = pick(c);
+        flips++;
+        if (x == 0) continue;
+        flip(x);
+        if (int(unsat.size()) < best_unsat) {
+            best_unsat = unsat.size();
+            best = value;
+        }
+    }
+    return flips;
+}
+
+std::optional<Valuation*> SLS::solve(Valuation *va, const double seconds) {
+    // no flip satisfies an empty clause
+    for (int c = 0; c < m; c++) {
+        if (start[c] == start[c + 1]) return std::nullopt;
+    }
+    std::bernoulli_distribution coin;
+    for (int i = 1; i <= pnum; i++) value[i] = coin(rng);
+    init();
+
+    const auto begin = std::chrono::steady_clock::now();
+    while (!unsat.empty()) {
+        run(1 << 20);
+        const std::chrono::duration<double> d = std::chrono::steady_clock::now() - begin;
+        if (seconds != 0 && seconds <= d.count()) return std::nullopt;
+    }
+    for (int i = 1; i <= pnum; i++) va->assign(Var(i), value[i] ? PValue::TRUE : PValue::FALSE, 0);
+    return va;
+}
+
+int SLS::walk(Valuation *va, const std::uint64_t max_flips) {
+    for (int i = 1; i <= pnum; i++) {
+        const auto v = Var(i);
+        const auto cur = va->get_value(v);
+        fixed[i] = (cur != PValue::BOTTOM);
+        value[i] = ((fixed[i] ? cur : va->get_cache(v)) == PValue::TRUE);
+    }
+    init();
+    run(max_flips);
+    for (int i = 1; i <= pnum; i++) {
+        if (!fixed[i]) va->set_cache(Var(i), best[i] ? PValue::TRUE : PValue::FALSE);
+    }
+    return best_unsat;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../cnf.hpp"
+#include <vector>
+#include <optional>
+#include <random>
+
+// ProbSAT (Balint and Schoening, 2012): a random falsified clause flips one of its
+// variables, chosen with probability (1 + break)^-cb where break is the number of
+// clauses which the flip would falsify.
+struct SLS {
+    SLS() = delete;
+    // searches over the first clauses_ clauses of cnf
+    SLS(CNF *cnf_, const int clauses_);
+
+    // for -m sls: walks from a random assignment until a model is found or
+    // seconds pass (0 means no limit), then assigns the model to va; nullopt at
+    // once for an empty clause
+    std::optional<Valuation*> solve(Valuation *va, const double seconds);
+
+    // Phase oracle of CDCL: starts from the saved phases of va, where variables
+    // assigned at level 0 are never flipped, and writes the best assignment back
+    // as saved phases. Returns the number of clauses it falsifies.
+    int walk(Valuation *va, const std::uint64_t max_flips);
+
+private:
+    int pnum, m;
+    // clause c is lits[start[c] .. start[c + 1])
+    std::vector<Literal> lits;
+    std::vector<int> start;
+    // clauses containing literal p are occ[occ_start[p] .. occ_start[p + 1])
+    std::vector<int> occ, occ_start;
+
+    std::vector<char> value, fixed, best;
+    std::vector<int> true_count;
+    std::vector<int> critical;  // xor of the true variables, so the only one while true_count is 1
+    std::vector<int> break_count;
+    std::vector<int> unsat, where;  // falsified clauses and their positions in unsat
+    std::vector<double> prob;       // prob[b] = (1 + b)^-cb
+    std::vector<double> weight;     // scratch buffer of pick()
+    int best_unsat;
+    std::mt19937 rng;
+
+    void init();
+    void flip(const int x);
+    int pick(const int c);
+    std::uint64_t run(const std::uint64_t max_flips);
+    bool is_true(const Literal p) const;
+};
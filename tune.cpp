@@ -0,0 +1,240 @@
+#include "tune.hpp"
+#include "batch.hpp"
+#include "util.hpp"
+#include "cdcl/cdcl.hpp"
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// the values the search tries for each option; luby_unit only matters under -P luby
+const std::vector<std::pair<std::string, std::vector<std::string>>> space {
+    { "heuristic", { "vsids", "lrb", "chb", "switch" } },
+    { "vsids_div", { "2", "5", "10", "20" } },
+    { "vsids_span", { "50", "100", "200", "500", "1000" } },
+    { "chrono", { "0", "50", "100", "200" } },
+    { "restart_window", { "25", "50", "100" } },
+    { "restart_margin", { "0.7", "0.75", "0.8", "0.85", "0.9" } },
+    { "reduce_base", { "2000", "5000", "10000", "20000", "40000" } },
+    { "reduce_step", { "100", "300", "500", "1000" } },
+    { "keep_lbd", { "2", "3", "4", "6" } },
+    { "rephase_interval", { "250", "500", "1000", "2000", "4000" } },
+    { "walk_flips", { "25", "100", "400" } },
+    { "chrono_conflicts", { "0", "1000", "4000", "16000" } },
+};
+
+struct instance {
+    std::string file;
+    std::string text;
+    cdcl::Result known;  // the first definite answer of any run
+};
+
+struct run_result {
+    cdcl::Result res;
+    double cost;
+};
+
+double thread_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+run_result run_one(const instance &inst, const config &cfg, const tune_options &opt) {
+    std::istringstream in(inst.text);
+    int pn = 0;
+    std::vector<AtMost> cards;
+    std::vector<raw_clause> xors;
+    auto clauses = parse_clauses(in, pn, &cards, &xors);
+    CNF cnf(std::move(*clauses), std::move(cards), std::move(xors));
+    Valuation va(cnf.get_pnum());
+    run_result ret { cdcl::Result::Unknown, 0 };
+    const auto start = thread_seconds();
+    std::uint64_t conflicts = 0;
+    cdcl::with_heuristic<cdcl::default_policy>(cfg.branching.heuristic, [&](auto p) {
+        cdcl::Solver<decltype(p)> solver(&cnf, &va);
+        configure(solver, cfg);
+        solver.set_limits(cdcl::limits { opt.conflicts, opt.seconds });
+        ret.res = solver.search();
+        conflicts = solver.get_statistics().conflicts;
+    });
+    cnf.free();
+    if (opt.seconds == 0) {
+        ret.cost = (ret.res == cdcl::Result::Unknown ? 2.0 * opt.conflicts : double(conflicts));
+    } else {
+        ret.cost = (ret.res == cdcl::Result::Unknown ? 2 * opt.seconds : thread_seconds() - start);
+    }
+    return ret;
+}
+
+std::string serialize(const config &c) {
+    std::ostringstream ss;
+    write_config(ss, c);
+    return ss.str();
+}
+
+struct tuner {
+    const tune_options &opt;
+    int threads;
+    std::mt19937_64 rng;
+    bool consistent;
+
+    // the cost of every candidate summed over the instances, all of them run on the pool
+    std::vector<double> evaluate(const std::vector<config> &cands, std::vector<instance> &insts) {
+        const std::size_t n = cands.size() * insts.size();
+        std::vector<run_result> results(n);
+        std::atomic<std::size_t> next(0);
+        auto worker = [&] {
+            while (true) {
+                const auto i = next.fetch_add(1);
+                if (n <= i) return;
+                results[i] = run_one(insts[i % insts.size()], cands[i / insts.size()], opt);
+            }
+        };
+        const int t = std::max(1, std::min(threads, int(n)));
+        if (t == 1) {
+            worker();
+        } else {
+            std::vector<std::thread> pool;
+            pool.reserve(t);
+            for (int k = 0; k < t; k++) pool.emplace_back(worker);
+            for (auto &th : pool) th.join();
+        }
+
+        std::vector<double> ret(cands.size(), 0);
+        for (std::size_t i = 0; i < n; i++) {
+            auto &inst = insts[i % insts.size()];
+            const auto res = results[i].res;
+            ret[i / insts.size()] += results[i].cost;
+            if (res == cdcl::Result::Unknown) continue;
+            if (inst.known == cdcl::Result::Unknown) inst.known = res;
+            if (inst.known != res) {
+                std::cerr << "c tune: " << inst.file << " was found both SAT and UNSAT" << std::endl;
+                consistent = false;
+            }
+        }
+        return ret;
+    }
+
+    // c with one or two options set to another of their values
+    config mutate(const config &c) {
+        auto ret = c;
+        const int k = 1 + int(rng() % 2);
+        for (int i = 0; i < k; i++) {
+            const auto &[ key, values ] = space[rng() % space.size()];
+            const auto cur = get_option(ret, key);
+            std::vector<std::string> others;
+            for (const auto &v : values) {
+                if (v != cur) others.push_back(v);
+            }
+            if (!others.empty()) set_option(ret, key, others[rng() % others.size()]);
+        }
+        return ret;
+    }
+
+    // the best configuration found for insts, starting from base of cost base_cost, and its cost
+    std::pair<config, double> tune(const std::string &family, const config &base, const double base_cost,
+                                   std::vector<instance> &insts) {
+        auto best = base;
+        auto best_cost = base_cost;
+        std::cerr << "c tune: " << family << " base " << best_cost << std::endl;
+        std::set<std::string> seen { serialize(base) };
+        int tried = 0;
+        while (tried < opt.candidates && consistent) {
+            std::vector<config> cands;
+            // a few attempts per slot, as the neighbourhood of a small space can run out
+            for (int a = 0; a < 8 * threads && int(cands.size()) < threads && tried + int(cands.size()) < opt.candidates; a++) {
+                auto c = mutate(best);
+                if (seen.insert(serialize(c)).second) cands.push_back(c);
+            }
+            if (cands.empty()) break;
+            tried += cands.size();
+            const auto costs = evaluate(cands, insts);
+            const auto i = std::min_element(std::begin(costs), std::end(costs)) - std::begin(costs);
+            if (costs[i] < best_cost) {
+                best = cands[i];
+                best_cost = costs[i];
+                std::cerr << "c tune: " << family << " candidate " << tried << " improves to " << best_cost << std::endl;
+            }
+        }
+        return { best, best_cost };
+    }
+};
+
+std::string family_of(const std::string &file) {
+    const auto name = fs::path(file).parent_path().filename().string();
+    return name.empty() ? "instances" : name;
+}
+
+}
+
+std::optional<std::vector<std::string>> collect_training_set(const std::string &source) {
+    auto ret = collect_instances(source);
+    std::error_code ec;
+    if (!ret.has_value() || !fs::is_directory(source, ec)) return ret;
+    std::vector<std::string> dirs;
+    for (const auto &e : fs::directory_iterator(source, ec)) {
+        if (e.is_directory(ec)) dirs.push_back(e.path().string());
+    }
+    std::sort(std::begin(dirs), std::end(dirs));
+    for (const auto &d : dirs) {
+        const auto files = collect_instances(d);
+        if (!files.has_value()) return std::nullopt;
+        ret->insert(std::end(*ret), std::begin(*files), std::end(*files));
+    }
+    return ret;
+}
+
+bool run_tune(const std::vector<std::string> &files, const config &base, const tune_options &opt) {
+    std::map<std::string, std::vector<instance>> families;
+    for (const auto &f : files) {
+        std::ifstream in(f);
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        std::istringstream check(ss.str());
+        int pn = 0;
+        std::vector<AtMost> cards;
+        std::vector<raw_clause> xors;
+        if (!in || !parse_clauses(check, pn, &cards, &xors).has_value()) {
+            std::cerr << "c tune: cannot read " << f << std::endl;
+            return false;
+        }
+        families[family_of(f)].push_back(instance { f, ss.str(), cdcl::Result::Unknown });
+    }
+
+    std::error_code ec;
+    if (!opt.output.empty()) fs::create_directories(opt.output, ec);
+
+    const int threads = (opt.threads == 0 ? int(std::thread::hardware_concurrency()) : opt.threads);
+    tuner t { opt, std::max(1, threads), std::mt19937_64(1), true };
+    for (auto &[ family, insts ] : families) {
+        const auto base_cost = t.evaluate({ base }, insts)[0];
+        const auto [ best, cost ] = t.tune(family, base, base_cost, insts);
+        if (!t.consistent) return false;
+
+        std::ofstream file_out;
+        if (!opt.output.empty()) {
+            file_out.open((fs::path(opt.output) / (family + ".conf")).string());
+            if (!file_out) return false;
+        }
+        std::ostream &out = (opt.output.empty() ? std::cout : file_out);
+        out << "# family " << family << ", " << insts.size() << " instances\n"
+            << "# cost " << cost << ", base " << base_cost << "\n";
+        write_config(out, best);
+        if (opt.output.empty()) out << '\n';
+        out.flush();
+        if (!out) return false;
+    }
+    return true;
+}
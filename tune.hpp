@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include "config.hpp"
+
+struct tune_options {
+    int threads;              // 0 picks the hardware concurrency
+    std::uint64_t conflicts;  // per run, 0 means no limit
+    double seconds;           // per run, 0 means no limit; one of the two limits is needed
+    int candidates;           // configurations tried per family besides the starting one
+    std::string output;       // directory receiving <family>.conf, empty means stdout
+};
+
+// the instances of collect_instances(source), and if source is a directory, those of
+// each of its subdirectories too; nullopt if any of them cannot be read
+std::optional<std::vector<std::string>> collect_training_set(const std::string &source);
+
+// Tunes a configuration per family of instances, the directory each one is in. The
+// search starts from base; every round changes one or two options of the best
+// configuration so far, once per thread, runs every candidate on every instance of the
+// family on a pool of threads, and keeps the best candidate if it beats the incumbent.
+// A run costs its CPU seconds, or its conflicts without a time limit, and one which
+// runs out of its limit twice the limit (PAR-2). The search is seeded, so the same
+// instances and options give the same candidates. Writes the best configuration of each
+// family with its cost and that of base; false if the files cannot be read or written,
+// or if two configurations disagree on the satisfiability of an instance.
+bool run_tune(const std::vector<std::string> &files, const config &base, const tune_options &opt);
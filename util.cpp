@@ -2,42 +2,347 @@
 #include <algorithm>
 #include "util.hpp"
 #include <sstream>
+#include <climits>
+#include <cstdlib>
 
-std::tuple<CNF*, int, int> parse() {
-    int hw;
+namespace {
+
+// a literal of a variable among the pn declared ones
+bool in_range(const int e, const int pn) {
+    return e != INT_MIN && std::abs(e) <= pn;
+}
+
+// one clause or cardinality constraint of the cnf+ format
+bool read_constraint(std::istream &in, const int pn, std::vector<raw_clause> &clauses, std::vector<AtMost> &cards) {
+    raw_clause v;
+    while (true) {
+        const int c = (in >> std::ws).peek();
+        if (c == '<' || c == '>') {
+            std::string s;
+            int k;
+            if (!(in >> s >> k) || (s != "<=" && s != ">=")) return false;
+            if (s == ">=") {
+                // at least k of v is at most |v| - k of their negations
+                for (auto &e : v) e = ~e;
+                k = int(v.size()) - k;
+            }
+            cards.push_back(AtMost { std::move(v), k });
+            return true;
+        }
+        int e;
+        if (!(in >> e)) return false;
+        if (e == 0) {
+            clauses.emplace_back(std::move(v));
+            return true;
+        }
+        if (!in_range(e, pn)) return false;
+        v.push_back(from_dimacs(e));
+    }
+}
+
+// "x l1 l2 ... 0" of CryptoMiniSat: the XOR of the literals is true
+bool read_xor(std::istream &in, const int pn, std::vector<raw_clause> &xors) {
+    in.get();
+    raw_clause v;
+    int e;
+    while (in >> e) {
+        if (e == 0) {
+            xors.emplace_back(std::move(v));
+            return true;
+        }
+        if (!in_range(e, pn)) return false;
+        v.push_back(from_dimacs(e));
+    }
+    return false;
+}
+
+// "c p show v1 v2 ... 0" of the model counting competition or "c ind v1 v2 ... 0"
+void read_projection(const std::string &line, std::vector<Var> &show) {
+    std::stringstream ss(line);
+    std::string c, s;
+    ss >> c >> s;
+    if (s == "p") ss >> s;
+    if (s != "show" && s != "ind") return;
+    int v;
+    while (ss >> v && v != 0) show.push_back(Var(v));
+}
+
+// at most the clauses which the rest of in can hold, two bytes each, to reserve for
+// a header which may lie; a stream which cannot seek is trusted up to a million
+std::size_t clauses_left(std::istream &in) {
+    const auto cur = in.tellg();
+    if (cur < 0) return std::size_t(1) << 20;
+    in.seekg(0, std::ios::end);
+    const auto end = in.tellg();
+    in.seekg(cur);
+    return end < cur ? 0 : std::size_t(end - cur) / 2;
+}
+
+// comment lines in front of the next constraint
+void skip_comments(std::istream &in, std::vector<Var> *show) {
+    std::string s;
+    while ((in >> std::ws).peek() == 'c') {
+        std::getline(in, s);
+        if (show != nullptr) read_projection(s, *show);
+    }
+}
+
+}
+
+std::optional<std::vector<raw_clause>> parse_clauses(std::istream &in, int &pn,
+                                                     std::vector<AtMost> *cards, std::vector<raw_clause> *xors,
+                                                     std::vector<Var> *show) {
     std::string cnf_;
-    int pn;
     int line;
     {
         std::string s;
         while (true) {
-            std::getline(std::cin, s);
+            if (!std::getline(in, s)) return std::nullopt;
             std::stringstream ss;
             ss << s;
             char c;
-            ss >> c;
-            if (c == 'c') continue;
-            ss >> cnf_ >> pn >> line;
+            if (!(ss >> c)) continue;
+            if (c == 'c') {
+                if (show != nullptr) read_projection(s, *show);
+                continue;
+            }
+            if (!(ss >> cnf_ >> pn >> line) || pn < 0 || line < 0) return std::nullopt;
             break;
         }
     }
     std::vector<raw_clause> ret;
-    ret.reserve(line);
+    ret.reserve(std::min<std::size_t>(line, clauses_left(in)));
+    const bool plus = (cnf_ == "cnf+");
+    if (plus && cards == nullptr) return std::nullopt;
     for (int i = 0; i < line; i++) {
-        std::vector<int> v;
+        if (show != nullptr) skip_comments(in, show);
+        if ((in >> std::ws).peek() == 'x') {
+            if (xors == nullptr || !read_xor(in, pn, *xors)) return std::nullopt;
+            continue;
+        }
+        if (plus) {
+            if (!read_constraint(in, pn, ret, *cards)) return std::nullopt;
+            continue;
+        }
+        raw_clause v;
         while (true) {
             int e;
-            std::cin >> e;
+            if (!(in >> e)) return std::nullopt;
             if (e == 0) break;
-            v.push_back(e);
+            if (!in_range(e, pn)) return std::nullopt;
+            v.push_back(from_dimacs(e));
         }
         ret.emplace_back(std::move(v));
     }
+    if (show != nullptr) {
+        skip_comments(in, show);
+        for (const auto v : *show) {
+            if (index(v) < 1 || pn < index(v)) return std::nullopt;
+        }
+    }
+    return ret;
+}
 
-    CNF *cnf = new CNF(std::move(ret));
+std::tuple<CNF*, int, int> parse(std::istream &in) {
+    int pn;
+    std::vector<AtMost> cards;
+    std::vector<raw_clause> xors;
+    std::vector<Var> show;
+    auto ret = parse_clauses(in, pn, &cards, &xors, &show);
+    if (!ret.has_value()) return std::make_tuple(nullptr, 0, 0);
+    const int line = ret->size() + cards.size() + xors.size();
+    CNF *cnf = new CNF(std::move(*ret), std::move(cards), std::move(xors));
+    if (!show.empty()) cnf->set_projection(std::move(show));
     return std::make_tuple(cnf, pn, line);
 }
 
+bool parse_wcnf(std::istream &in, int &pn, std::vector<raw_clause> &hard, std::vector<SoftClause> &soft) {
+    pn = 0;
+    std::uint64_t top = 0;  // 0: "h" marks the hard clauses
+    std::string s;
+    while (in >> s) {
+        if (s[0] == 'c') {
+            std::getline(in, s);
+            continue;
+        }
+        if (s == "p") {
+            std::string fmt;
+            int n;
+            if (!(in >> fmt >> pn >> n >> top) || fmt != "wcnf") return false;
+            continue;
+        }
+        const bool h = (s == "h");
+        std::uint64_t w = 0;
+        if (!h) {
+            std::istringstream ss(s);
+            if (s[0] == '-' || !(ss >> w) || !ss.eof()) return false;
+        }
+        raw_clause v;
+        bool closed = false;
+        int e;
+        while (in >> e) {
+            if (e == 0) {
+                closed = true;
+                break;
+            }
+            if (e == INT_MIN) return false;
+            v.push_back(from_dimacs(e));
+            pn = std::max(pn, std::abs(e));
+        }
+        if (!closed) return false;
+        if (h || (top != 0 && top <= w)) hard.emplace_back(std::move(v));
+        else if (w != 0) soft.push_back(SoftClause { std::move(v), w });
+    }
+    return true;
+}
+
+namespace {
+
+const char* skip_line(const char *cur, const char *last) {
+    while (cur != last && *cur != '\n') cur++;
+    return cur == last ? cur : cur + 1;
+}
+
+const char* skip_space(const char *cur, const char *last) {
+    while (cur != last && (*cur == ' ' || *cur == '\t' || *cur == '\r' || *cur == '\n')) cur++;
+    return cur;
+}
+
+bool read_int(const char *&cur, const char *last, int &x) {
+    cur = skip_space(cur, last);
+    bool neg = false;
+    if (cur != last && *cur == '-') {
+        neg = true;
+        cur++;
+    }
+    if (cur == last || *cur < '0' || '9' < *cur) return false;
+    long long y = 0;
+    while (cur != last && '0' <= *cur && *cur <= '9') {
+        y = y * 10 + (*cur++ - '0');
+        if (INT_MAX < y) return false;
+    }
+    x = int(neg ? -y : y);
+    return true;
+}
+
+}
+
+bool parse_buffer(const char *fst, const char *last, int &pn, std::vector<raw_clause> &out) {
+    const char *cur = fst;
+    int line = 0;
+    // header: "p cnf <pn> <line>"
+    while (true) {
+        cur = skip_space(cur, last);
+        if (cur == last) return false;
+        if (*cur == 'c') {
+            cur = skip_line(cur, last);
+            continue;
+        }
+        if (last - cur < 5 || std::string(cur, cur + 5) != "p cnf") return false;
+        cur += 5;
+        if (!read_int(cur, last, pn) || !read_int(cur, last, line) || pn < 0 || line < 0) return false;
+        break;
+    }
+    // every clause takes at least two bytes, so a lying header cannot reserve more than that
+    out.reserve(out.size() + std::min<std::size_t>(line, last - cur));
+    for (int i = 0; i < line; i++) {
+        raw_clause v;
+        while (true) {
+            cur = skip_space(cur, last);
+            if (cur != last && (*cur == 'c' || *cur == '%')) {
+                cur = skip_line(cur, last);
+                continue;
+            }
+            int e;
+            if (!read_int(cur, last, e)) return false;
+            if (e == 0) break;
+            if (!in_range(e, pn)) return false;
+            v.push_back(from_dimacs(e));
+        }
+        out.emplace_back(std::move(v));
+    }
+    return true;
+}
+
+bool parse_binary(const char *fst, const char *last, int &pn, std::vector<raw_clause> &out) {
+    auto read = [&](std::int32_t &x) {
+        if (last - fst < 4) return false;
+        const auto *b = reinterpret_cast<const unsigned char*>(fst);
+        x = std::int32_t(std::uint32_t(b[0]) | std::uint32_t(b[1]) << 8 |
+                         std::uint32_t(b[2]) << 16 | std::uint32_t(b[3]) << 24);
+        fst += 4;
+        return true;
+    };
+    std::int32_t n, line;
+    if (!read(n) || !read(line) || n < 0 || line < 0) return false;
+    pn = n;
+    // every clause takes at least its terminating 0
+    out.reserve(out.size() + std::min<std::size_t>(line, (last - fst) / 4));
+    for (int i = 0; i < line; i++) {
+        raw_clause v;
+        while (true) {
+            std::int32_t e;
+            if (!read(e)) return false;
+            if (e == 0) break;
+            if (!in_range(e, pn)) return false;
+            v.push_back(from_dimacs(e));
+        }
+        out.emplace_back(std::move(v));
+    }
+    return true;
+}
+
+std::optional<std::vector<Literal>> parse_model(std::istream &in) {
+    bool sat = false;
+    std::vector<Literal> ret;
+    std::string s;
+    while (std::getline(in, s)) {
+        if (s.size() < 2) continue;
+        if (s[0] == 's') {
+            sat = (s.find("UNSAT") == std::string::npos && s.find("SAT") != std::string::npos);
+        } else if (s[0] == 'v') {
+            std::stringstream ss(s.substr(1));
+            int e;
+            while (ss >> e) {
+                if (e != 0) ret.push_back(from_dimacs(e));
+            }
+        }
+    }
+    if (!sat) return std::nullopt;
+    return ret;
+}
+
+CNF* make_queens(const int n) {
+    auto square = [&](const int i, const int j) {
+        return make_lit(Var(i * n + j + 1), false);
+    };
+    std::vector<raw_clause> clauses;
+    std::vector<AtMost> cards;
+    // a queen on every row, and n queens leave no column empty
+    for (int i = 0; i < n; i++) {
+        raw_clause row, col;
+        for (int j = 0; j < n; j++) {
+            row.push_back(square(i, j));
+            col.push_back(square(j, i));
+        }
+        clauses.push_back(row);
+        cards.push_back(AtMost { std::move(row), 1 });
+        cards.push_back(AtMost { std::move(col), 1 });
+    }
+    // diagonals i + j = d and i - j = d - (n - 1) with at least two squares
+    for (int d = 1; d < 2 * n - 2; d++) {
+        raw_clause diag, anti;
+        for (int i = 0; i < n; i++) {
+            const int j = d - i, k = i - d + n - 1;
+            if (0 <= j && j < n) diag.push_back(square(i, j));
+            if (0 <= k && k < n) anti.push_back(square(i, k));
+        }
+        cards.push_back(AtMost { std::move(diag), 1 });
+        cards.push_back(AtMost { std::move(anti), 1 });
+    }
+    return new CNF(std::move(clauses), std::move(cards));
+}
+
 bool check_ans(const std::vector<std::vector<int>> &board, const int hw) {
     auto valid = [&](const int h, const int w) {
         return 0 <= h && h < hw &&
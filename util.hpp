@@ -1,6 +1,32 @@
 #include <tuple>
 #include <vector>
+#include <optional>
+#include <istream>
 #include "cnf.hpp"
 
-std::tuple<CNF*, int, int> parse();
+// nullopt if the input ends before the header or the declared clauses, or if a literal
+// or a projected variable is beyond the declared variables.
+// With cards, also reads the "p cnf+" format of MiniCard, where a constraint line
+// "l1 l2 ... <= k" or "l1 l2 ... >= k" takes the place of a clause.
+// With xors, also reads the "x l1 l2 ... 0" lines of CryptoMiniSat (the XOR of the literals is true).
+// With show, collects the projection of "c p show ... 0" and "c ind ... 0" comment lines.
+std::optional<std::vector<raw_clause>> parse_clauses(std::istream &in, int &pn,
+                                                     std::vector<AtMost> *cards = nullptr,
+                                                     std::vector<raw_clause> *xors = nullptr,
+                                                     std::vector<Var> *show = nullptr);
+// the CNF, its variables and constraints; a null CNF for what parse_clauses() rejects
+std::tuple<CNF*, int, int> parse(std::istream &in);
+// Weighted MaxSAT: "p wcnf <vars> <clauses> <top>" with "<weight> l1 ... 0" lines, hard when
+// weight >= top, or the header-less format with "h l1 ... 0" for hard clauses.
+// false on malformed input; pn is the number of variables.
+bool parse_wcnf(std::istream &in, int &pn, std::vector<raw_clause> &hard, std::vector<SoftClause> &soft);
+// DIMACS text held in memory; clauses are appended to out so that its storage can be reused.
+// Both return false on malformed input, including literals beyond pn.
+bool parse_buffer(const char *fst, const char *last, int &pn, std::vector<raw_clause> &out);
+// little-endian int32: pnum, clause count, then the literals of every clause each followed by 0
+bool parse_binary(const char *fst, const char *last, int &pn, std::vector<raw_clause> &out);
+// literals of the "v" lines of a solver output; nullopt unless it says SATISFIABLE
+std::optional<std::vector<Literal>> parse_model(std::istream &in);
+// N-queens with at-most-one constraints on rows, columns and diagonals; square (i, j) is i * n + j + 1
+CNF* make_queens(const int n);
 bool check_ans(const std::vector<std::vector<int>> &board, const int hw);
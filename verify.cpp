@@ -0,0 +1,63 @@
+#include <iostream>
+#include <fstream>
+#include <unistd.h>
+#include "util.hpp"
+#include "checker.hpp"
+
+// verify [-j threads] expr.cnf model.txt
+int main(int argc, char *argv[]) {
+    int threads = 0;
+    {
+        int opt;
+        while ((opt = getopt(argc, argv, "j:")) != -1) {
+            switch (opt) {
+                case 'j':
+                    threads = std::stoi(optarg);
+                    break;
+                default:
+                    std::cerr << "usage: " << argv[0] << " [-j threads] expr.cnf model.txt" << std::endl;
+                    return 2;
+            }
+        }
+    }
+    if (argc - optind != 2) {
+        std::cerr << "usage: " << argv[0] << " [-j threads] expr.cnf model.txt" << std::endl;
+        return 2;
+    }
+
+    std::ifstream cnf_in(argv[optind]), model_in(argv[optind + 1]);
+    if (!cnf_in || !model_in) {
+        std::cerr << "cannot open input" << std::endl;
+        return 2;
+    }
+
+    int pn;
+    const auto parsed = parse_clauses(cnf_in, pn);
+    if (!parsed.has_value()) {
+        std::cerr << "malformed CNF" << std::endl;
+        return 2;
+    }
+    const auto &clauses = *parsed;
+    const auto model = parse_model(model_in);
+    if (!model.has_value()) {
+        std::cout << "no model: the answer is not SATISFIABLE" << std::endl;
+        return 1;
+    }
+
+    ModelChecker checker(clauses);
+    for (auto p : *model) {
+        if (checker.assign(p)) continue;
+        std::cout << "variable " << index(var(p)) << " is assigned both ways" << std::endl;
+        return 1;
+    }
+
+    auto res = checker.find_falsified(threads);
+    if (res.has_value()) {
+        std::cout << "clause " << *res + 1 << " is not satisfied:";
+        for (auto p : clauses[*res]) std::cout << ' ' << to_dimacs(p);
+        std::cout << " 0" << std::endl;
+        return 1;
+    }
+    std::cout << "verified: " << checker.size() << " clauses satisfied" << std::endl;
+    return 0;
+}